@@ -8,6 +8,7 @@ export interface ReadyMessage {
 export interface PartialMessage {
   type: 'partial';
   text: string;
+  stable?: string;  // Prefix of text that later partials keep unchanged
 }
 
 export interface FinalMessage {
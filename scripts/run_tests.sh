@@ -3,7 +3,7 @@
 # Master test runner for whisper-stream-server
 #
 # Runs all available tests:
-#   1. C++ Unit tests (AudioBuffer, VAD State Machine)
+#   1. C++ Unit tests (AudioBuffer, PCM conversion, VAD State Machine)
 #   2. C++ Integration tests (requires whisper model)
 #   3. E2E TypeScript tests (requires running server)
 #
@@ -67,6 +67,26 @@ if $RUN_UNIT; then
         fi
     fi
 
+    if [ -f "$BUILD_DIR/test_pcm_convert" ]; then
+        echo ""
+        echo "Running PCM conversion tests..."
+        if "$BUILD_DIR/test_pcm_convert" --reporter compact 2>&1 | tail -3; then
+            UNIT_PASSED=$((UNIT_PASSED + 1))
+        else
+            UNIT_FAILED=$((UNIT_FAILED + 1))
+        fi
+    fi
+
+    if [ -f "$BUILD_DIR/test_admission_queue" ]; then
+        echo ""
+        echo "Running admission queue tests..."
+        if "$BUILD_DIR/test_admission_queue" --reporter compact 2>&1 | tail -3; then
+            UNIT_PASSED=$((UNIT_PASSED + 1))
+        else
+            UNIT_FAILED=$((UNIT_FAILED + 1))
+        fi
+    fi
+
     if [ -f "$BUILD_DIR/test_vad_state_machine" ]; then
         echo ""
         echo "Running VAD State Machine tests..."
@@ -0,0 +1,59 @@
+#include "admission_queue.hpp"
+
+#include <algorithm>
+
+AdmissionQueue::AdmissionQueue(int64_t aging_ms)
+    : aging_ms_(std::max<int64_t>(0, aging_ms)) {
+}
+
+bool AdmissionQueue::push(const std::string& id, int priority, int64_t now_ms) {
+    if (contains(id)) {
+        return false;
+    }
+    waiters_.push_back({id, std::clamp(priority, static_cast<int>(LOW), static_cast<int>(HIGH)), now_ms});
+    return true;
+}
+
+bool AdmissionQueue::remove(const std::string& id) {
+    auto it = std::find_if(waiters_.begin(), waiters_.end(),
+                           [&id](const Waiter& w) { return w.id == id; });
+    if (it == waiters_.end()) {
+        return false;
+    }
+    waiters_.erase(it);
+    return true;
+}
+
+bool AdmissionQueue::contains(const std::string& id) const {
+    return std::any_of(waiters_.begin(), waiters_.end(),
+                       [&id](const Waiter& w) { return w.id == id; });
+}
+
+AdmissionQueue::Waiter AdmissionQueue::pop(int64_t now_ms) {
+    // Few waiters at a time (bounded by connected sessions), so a scan is fine.
+    // Strict > keeps the earliest arrival on ties.
+    size_t best = 0;
+    int64_t best_score = 0;
+    for (size_t i = 0; i < waiters_.size(); ++i) {
+        int64_t score = (now_ms - waiters_[i].enqueued_ms) + waiters_[i].priority * aging_ms_;
+        if (i == 0 || score > best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    Waiter waiter = waiters_[best];
+    waiters_.erase(waiters_.begin() + best);
+    return waiter;
+}
+
+int64_t AdmissionQueue::oldestWaitMs(int64_t now_ms) const {
+    // Arrival order: the front entry has waited longest
+    return waiters_.empty() ? 0 : std::max<int64_t>(0, now_ms - waiters_.front().enqueued_ms);
+}
+
+int AdmissionQueue::parsePriority(const std::string& name) {
+    if (name == "low") return LOW;
+    if (name == "high") return HIGH;
+    return NORMAL;
+}
@@ -0,0 +1,55 @@
+#ifndef ADMISSION_QUEUE_HPP
+#define ADMISSION_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wait queue for sessions that started speaking while every context was leased.
+//
+// A released context goes to the waiter with the largest effective wait:
+//     (now - enqueued_ms) + priority * aging_ms
+// Within a priority class that is strict FIFO. A higher class is served first,
+// but only by aging_ms per class: a lower-class waiter that has waited that much
+// longer wins anyway, so no class can be starved.
+//
+// Not thread-safe; the owner guards it (WhisperServer uses admission_mutex_).
+class AdmissionQueue {
+public:
+    enum Priority { LOW = 0, NORMAL = 1, HIGH = 2 };
+
+    struct Waiter {
+        std::string id;
+        int priority = NORMAL;
+        int64_t enqueued_ms = 0;
+    };
+
+    explicit AdmissionQueue(int64_t aging_ms = 5000);
+
+    // Queue a waiter. Returns false (and keeps its place) if id is already queued.
+    bool push(const std::string& id, int priority, int64_t now_ms);
+
+    // Drop a waiter that no longer needs a context. Returns false if not queued.
+    bool remove(const std::string& id);
+
+    bool contains(const std::string& id) const;
+
+    // Remove and return the waiter to serve next. The queue must not be empty.
+    Waiter pop(int64_t now_ms);
+
+    // How long the longest-waiting entry has been queued (0 when empty)
+    int64_t oldestWaitMs(int64_t now_ms) const;
+
+    size_t size() const { return waiters_.size(); }
+    bool empty() const { return waiters_.empty(); }
+
+    // "low" / "high" map to LOW / HIGH; anything else is NORMAL
+    static int parsePriority(const std::string& name);
+
+private:
+    int64_t aging_ms_;
+    std::vector<Waiter> waiters_;  // Arrival order
+};
+
+#endif // ADMISSION_QUEUE_HPP
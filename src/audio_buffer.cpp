@@ -1,90 +1,311 @@
 #include "audio_buffer.hpp"
+#include "pcm_convert.hpp"
 
-AudioBuffer::AudioBuffer(float max_seconds, int sample_rate)
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define AUDIO_BUFFER_PAGE_RELEASE 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Consumed audio is handed back to the OS in runs of at least this many bytes
+static constexpr size_t kReleaseBytes = 16 * 1024;
+
+static void* allocateRing(size_t bytes) {
+#if AUDIO_BUFFER_PAGE_RELEASE
+    // Page-aligned and lazily committed: untouched or released pages cost nothing
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#else
+    return std::malloc(bytes);
+#endif
+}
+
+void AudioBuffer::RingFree::operator()(void* p) const {
+#if AUDIO_BUFFER_PAGE_RELEASE
+    munmap(p, bytes);
+#else
+    std::free(p);
+#endif
+}
+
+AudioBuffer::AudioBuffer(float max_seconds, int sample_rate, SampleFormat format)
     : max_samples_(static_cast<size_t>(max_seconds * sample_rate))
-    , sample_rate_(sample_rate) {
+    , headroom_(std::max<size_t>(1, static_cast<size_t>(sample_rate) / 4))
+    , capacity_(max_samples_ + headroom_)
+    , sample_rate_(sample_rate)
+    , format_(format)
+    , elem_size_(format == SampleFormat::INT16 ? sizeof(int16_t) : sizeof(float))
+    , storage_(allocateRing(capacity_ * elem_size_), RingFree{capacity_ * elem_size_}) {
+    if (!storage_) {
+        throw std::bad_alloc();
+    }
+    if (format_ == SampleFormat::INT16) {
+        ring_i16_ = static_cast<int16_t*>(storage_.get());
+    } else {
+        ring_ = static_cast<float*>(storage_.get());
+    }
+
+#if AUDIO_BUFFER_PAGE_RELEASE
+    page_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
 }
 
-void AudioBuffer::push(const int16_t* samples, size_t count) {
-    std::lock_guard<std::mutex> lock(mutex_);
+template <typename Store>
+void AudioBuffer::write(size_t count, Store store) {
+    uint64_t w = write_pos_.load(std::memory_order_relaxed);
+    size_t done = 0;
+
+    // Publish at most headroom_ samples at a time so a reader that loaded the
+    // previous write position never has its retained window overwritten unseen
+    while (done < count) {
+        size_t chunk = std::min(count - done, headroom_);
+        size_t idx = static_cast<size_t>(w % capacity_);
+        size_t first = std::min(chunk, capacity_ - idx);
+
+        store(idx, done, first);
+        if (chunk > first) {
+            store(0, done + first, chunk - first);
+        }
+
+        done += chunk;
+        w += chunk;
+        write_pos_.store(w, std::memory_order_release);
+    }
 
-    for (size_t i = 0; i < count; ++i) {
-        buffer_.push_back(int16ToFloat(samples[i]));
+    releaseConsumed(w);
+}
+
+void AudioBuffer::releaseConsumed(uint64_t write_pos) {
+#if AUDIO_BUFFER_PAGE_RELEASE
+    // Positions below the read cursor are never read again. Positions below
+    // write_pos - max_samples_ share slots with newer samples, so never go below that.
+    uint64_t r = read_pos_.load(std::memory_order_acquire);
+    uint64_t oldest = write_pos > max_samples_ ? write_pos - max_samples_ : 0;
+    uint64_t lo = std::max(released_pos_, oldest);
+    if (r <= lo || (r - lo) * elem_size_ < std::max(kReleaseBytes, page_size_)) return;
+
+    char* base = static_cast<char*>(storage_.get());
+    auto release = [&](size_t begin, size_t end) {
+        begin = (begin + page_size_ - 1) / page_size_ * page_size_;
+        end = end / page_size_ * page_size_;
+        if (end > begin) {
+#if defined(MADV_FREE_REUSABLE)
+            madvise(base + begin, end - begin, MADV_FREE_REUSABLE);
+#else
+            madvise(base + begin, end - begin, MADV_DONTNEED);
+#endif
+        }
+    };
+
+    size_t begin = static_cast<size_t>(lo % capacity_) * elem_size_;
+    size_t end = static_cast<size_t>(r % capacity_) * elem_size_;
+    if (begin < end) {
+        release(begin, end);
+    } else {
+        release(begin, capacity_ * elem_size_);
+        release(0, end);
     }
 
-    // Trim to max size
-    while (buffer_.size() > max_samples_) {
-        buffer_.pop_front();
+    // Resume from the last page boundary so partially covered pages are not skipped
+    released_pos_ = r - (end % page_size_) / elem_size_;
+#else
+    (void)write_pos;
+#endif
+}
+
+void AudioBuffer::push(const int16_t* samples, size_t count) {
+    if (format_ == SampleFormat::INT16) {
+        write(count, [this, samples](size_t idx, size_t offset, size_t n) {
+            std::memcpy(ring_i16_ + idx, samples + offset, n * sizeof(int16_t));
+        });
+    } else {
+        write(count, [this, samples](size_t idx, size_t offset, size_t n) {
+            pcmInt16ToFloat(samples + offset, ring_ + idx, n);
+        });
     }
 }
 
 void AudioBuffer::pushFloat(const float* samples, size_t count) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    for (size_t i = 0; i < count; ++i) {
-        buffer_.push_back(samples[i]);
+    if (format_ == SampleFormat::INT16) {
+        write(count, [this, samples](size_t idx, size_t offset, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                float scaled = std::round(samples[offset + i] * 32768.0f);
+                ring_i16_[idx + i] = static_cast<int16_t>(std::clamp(scaled, -32768.0f, 32767.0f));
+            }
+        });
+    } else {
+        write(count, [this, samples](size_t idx, size_t offset, size_t n) {
+            std::memcpy(ring_ + idx, samples + offset, n * sizeof(float));
+        });
     }
+}
+
+uint64_t AudioBuffer::startPos(uint64_t write_pos) const {
+    uint64_t r = read_pos_.load(std::memory_order_acquire);
+    uint64_t oldest = write_pos > max_samples_ ? write_pos - max_samples_ : 0;
+    return std::min(std::max(r, oldest), write_pos);
+}
 
-    // Trim to max size
-    while (buffer_.size() > max_samples_) {
-        buffer_.pop_front();
+size_t AudioBuffer::copyOut(uint64_t from, size_t count, float* out) const {
+    if (count == 0) return 0;
+
+    auto read = [this, out](size_t idx, size_t offset, size_t n) {
+        if (format_ == SampleFormat::INT16) {
+            pcmInt16ToFloat(ring_i16_ + idx, out + offset, n);
+        } else {
+            std::memcpy(out + offset, ring_ + idx, n * sizeof(float));
+        }
+    };
+
+    size_t idx = static_cast<size_t>(from % capacity_);
+    size_t first = std::min(count, capacity_ - idx);
+    read(idx, 0, first);
+    if (count > first) {
+        read(0, first, count - first);
     }
+
+    // Anything older than max retention at the *current* write position may have
+    // been overwritten while we were copying, and anything the consumer moved past
+    // meanwhile may have been released to the OS by the producer (reads as zeros)
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t w = write_pos_.load(std::memory_order_relaxed);
+    uint64_t oldest = std::max(w > max_samples_ ? w - max_samples_ : 0,
+                               read_pos_.load(std::memory_order_relaxed));
+    if (oldest <= from) return 0;
+
+    size_t lost = static_cast<size_t>(std::min<uint64_t>(count, oldest - from));
+    std::memmove(out, out + lost, (count - lost) * sizeof(float));
+    return lost;
 }
 
 size_t AudioBuffer::get(float* out, size_t max_samples, bool clear_retrieved) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    uint64_t start = startPos(w);
 
-    size_t count = std::min(max_samples, buffer_.size());
-    for (size_t i = 0; i < count; ++i) {
-        out[i] = buffer_[i];
-    }
+    size_t count = static_cast<size_t>(std::min<uint64_t>(max_samples, w - start));
+    size_t lost = copyOut(start, count, out);
+    count -= lost;
 
     if (clear_retrieved) {
-        for (size_t i = 0; i < count; ++i) {
-            buffer_.pop_front();
-        }
+        read_pos_.store(start + lost + count, std::memory_order_release);
     }
 
     return count;
 }
 
 std::vector<float> AudioBuffer::getLastMs(int ms) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    uint64_t start = startPos(w);
 
     size_t n_samples = static_cast<size_t>((ms / 1000.0f) * sample_rate_);
-    n_samples = std::min(n_samples, buffer_.size());
+    n_samples = static_cast<size_t>(std::min<uint64_t>(n_samples, w - start));
 
     std::vector<float> result(n_samples);
-    size_t start = buffer_.size() - n_samples;
-    for (size_t i = 0; i < n_samples; ++i) {
-        result[i] = buffer_[start + i];
-    }
+    size_t lost = copyOut(w - n_samples, n_samples, result.data());
+    result.resize(n_samples - lost);
 
     return result;
 }
 
 std::vector<float> AudioBuffer::getAll() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return std::vector<float>(buffer_.begin(), buffer_.end());
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    uint64_t start = startPos(w);
+
+    std::vector<float> result(static_cast<size_t>(w - start));
+    size_t lost = copyOut(start, result.size(), result.data());
+    result.erase(result.begin(), result.begin() + lost);
+
+    return result;
+}
+
+size_t AudioBuffer::getFrom(uint64_t& pos, float* out, size_t max_samples) const {
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    pos = std::max(pos, startPos(w));
+    if (pos >= w) return 0;
+
+    size_t count = static_cast<size_t>(std::min<uint64_t>(max_samples, w - pos));
+    size_t lost = copyOut(pos, count, out);
+    pos += lost;
+
+    return count - lost;
+}
+
+uint64_t AudioBuffer::writePosition() const {
+    return write_pos_.load(std::memory_order_acquire);
+}
+
+uint64_t AudioBuffer::readPosition() const {
+    return startPos(write_pos_.load(std::memory_order_acquire));
+}
+
+size_t AudioBuffer::peek(Span& first, Span& second) const {
+    first = Span{};
+    second = Span{};
+    if (format_ != SampleFormat::FLOAT32) return 0;
+
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    uint64_t start = startPos(w);
+    size_t count = static_cast<size_t>(w - start);
+
+    size_t idx = static_cast<size_t>(start % capacity_);
+    first.data = ring_ + idx;
+    first.size = std::min(count, capacity_ - idx);
+    second.data = ring_;
+    second.size = count - first.size;
+
+    return count;
+}
+
+size_t AudioBuffer::peekInt16(Int16Span& first, Int16Span& second) const {
+    first = Int16Span{};
+    second = Int16Span{};
+    if (format_ != SampleFormat::INT16) return 0;
+
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    uint64_t start = startPos(w);
+    size_t count = static_cast<size_t>(w - start);
+
+    size_t idx = static_cast<size_t>(start % capacity_);
+    first.data = ring_i16_ + idx;
+    first.size = std::min(count, capacity_ - idx);
+    second.data = ring_i16_;
+    second.size = count - first.size;
+
+    return count;
+}
+
+void AudioBuffer::consume(size_t count) {
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    uint64_t start = startPos(w);
+    read_pos_.store(start + std::min<uint64_t>(count, w - start), std::memory_order_release);
+}
+
+void AudioBuffer::keepLastMs(int ms) {
+    size_t keep = static_cast<size_t>((ms / 1000.0f) * sample_rate_);
+    size_t available = size();
+    if (available > keep) {
+        consume(available - keep);
+    }
 }
 
 void AudioBuffer::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    buffer_.clear();
+    read_pos_.store(write_pos_.load(std::memory_order_acquire), std::memory_order_release);
 }
 
 size_t AudioBuffer::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return buffer_.size();
+    uint64_t w = write_pos_.load(std::memory_order_acquire);
+    return static_cast<size_t>(w - startPos(w));
 }
 
 float AudioBuffer::durationMs() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return (buffer_.size() * 1000.0f) / sample_rate_;
+    return (size() * 1000.0f) / sample_rate_;
 }
 
 bool AudioBuffer::hasMinDuration(int min_ms) const {
-    std::lock_guard<std::mutex> lock(mutex_);
     size_t min_samples = static_cast<size_t>((min_ms / 1000.0f) * sample_rate_);
-    return buffer_.size() >= min_samples;
+    return size() >= min_samples;
 }
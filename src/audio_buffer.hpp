@@ -2,58 +2,151 @@
 #define AUDIO_BUFFER_HPP
 
 #include <vector>
-#include <deque>
-#include <mutex>
+#include <atomic>
+#include <memory>
 #include <cstdint>
 #include <cstring>
+#include <new>
 
-// Thread-safe ring buffer for accumulating incoming PCM audio
-// Converts int16 input to float32 (whisper's expected format)
+// Lock-free single-producer/single-consumer ring buffer for incoming PCM audio
+// Converts int16 input to float32 (whisper's expected format) with the
+// SIMD kernel from pcm_convert.hpp
+//
+// Threading contract:
+//   - Producer (one thread): push(), pushFloat()
+//   - Consumer (one thread at a time): get(..., true), consume(), clear()
+//   - Any thread: read-only methods (getAll(), getLastMs(), getFrom(), size(), ...).
+//     A read that races with the consumer returns only what is still unconsumed
+//     when the copy finishes, never released pages (see copyOut()).
+//
+// Samples are stored either as float32 (converted on push) or as raw int16
+// (converted on read), see SampleFormat. INT16 halves memory and defers the
+// conversion cost to the audio that is actually read.
+//
+// Storage is a fixed, contiguous array. When full, the producer overwrites the
+// oldest samples instead of waiting for the consumer; readers copy first and then
+// drop anything the producer overwrote during the copy, so no lock is needed.
+// On POSIX the array is mmap'd and the producer returns pages the consumer has
+// moved past to the OS, so resident memory follows how much audio is retained
+// (e.g. a short pre-roll while idle) rather than the full capacity.
 class AudioBuffer {
 public:
+    // How samples are held in the ring
+    enum class SampleFormat { FLOAT32, INT16 };
+
+    // Contiguous run of samples inside the ring
+    struct Span {
+        const float* data = nullptr;
+        size_t size = 0;
+    };
+
+    struct Int16Span {
+        const int16_t* data = nullptr;
+        size_t size = 0;
+    };
+
     // max_seconds: maximum audio to retain (default 30s for whisper's context)
-    explicit AudioBuffer(float max_seconds = 30.0f, int sample_rate = 16000);
+    explicit AudioBuffer(float max_seconds = 30.0f, int sample_rate = 16000,
+                         SampleFormat format = SampleFormat::FLOAT32);
 
-    // Push int16 PCM samples (from WebSocket). Thread-safe.
+    // Push int16 PCM samples (from WebSocket). Producer only.
     void push(const int16_t* samples, size_t count);
 
-    // Push float32 samples directly. Thread-safe.
+    // Push float32 samples directly (quantized in INT16 mode). Producer only.
     void pushFloat(const float* samples, size_t count);
 
-    // Get up to max_samples of audio. Returns actual count retrieved.
-    // If clear_retrieved is true, removes the returned samples from buffer.
-    // Thread-safe.
+    // Get up to max_samples of audio (oldest first). Returns actual count retrieved.
+    // If clear_retrieved is true, removes the returned samples from buffer (consumer only).
     size_t get(float* out, size_t max_samples, bool clear_retrieved = false);
 
     // Get the last N milliseconds of audio (for sliding window).
-    // Thread-safe.
     std::vector<float> getLastMs(int ms);
 
-    // Get all available audio without removing it. Thread-safe.
+    // Get all available audio without removing it.
     std::vector<float> getAll();
 
-    // Clear all buffered audio. Thread-safe.
+    // Read up to max_samples starting at absolute stream position pos (see
+    // writePosition()), without removing them. If pos is older than the oldest
+    // retained sample, pos is advanced to it. Returns the count read.
+    size_t getFrom(uint64_t& pos, float* out, size_t max_samples) const;
+
+    // Absolute stream positions: total samples ever pushed, and the position of
+    // the oldest sample still readable (write - size()).
+    uint64_t writePosition() const;
+    uint64_t readPosition() const;
+
+    // View the unread samples in place as up to two spans (the second is only
+    // non-empty when the data wraps around the end of the ring). Returns the total
+    // sample count. Consumer only; spans stay valid until the producer writes
+    // another headroomSamples() samples, so copy out promptly.
+    // peek() is for FLOAT32 buffers and peekInt16() for INT16 buffers; called on
+    // the other format they return 0 and empty spans.
+    size_t peek(Span& first, Span& second) const;
+    size_t peekInt16(Int16Span& first, Int16Span& second) const;
+
+    // Remove up to count of the oldest unread samples. Consumer only.
+    void consume(size_t count);
+
+    // Drop everything except the newest ms of audio (e.g. a pre-roll). Consumer only.
+    void keepLastMs(int ms);
+
+    // Clear all buffered audio. Consumer only.
     void clear();
 
-    // Get current buffer size in samples. Thread-safe.
+    // Get current buffer size in samples.
     size_t size() const;
 
-    // Get current buffer duration in milliseconds. Thread-safe.
+    // Get current buffer duration in milliseconds.
     float durationMs() const;
 
-    // Check if we have at least min_ms of audio. Thread-safe.
+    // Check if we have at least min_ms of audio.
     bool hasMinDuration(int min_ms) const;
 
+    // Samples the producer may write beyond max retention before overwriting
+    // memory that a concurrent reader could still be looking at.
+    size_t headroomSamples() const { return headroom_; }
+
+    SampleFormat format() const { return format_; }
+
 private:
-    std::deque<float> buffer_;
-    mutable std::mutex mutex_;
-    size_t max_samples_;
+    size_t max_samples_;    // Retention limit (oldest samples beyond this are dropped)
+    size_t headroom_;       // Extra physical slots; producer publishes every <= headroom_ samples
+    size_t capacity_;       // Physical ring size = max_samples_ + headroom_
     int sample_rate_;
+    SampleFormat format_;
+    size_t elem_size_;
+
+    struct RingFree {
+        size_t bytes;
+        void operator()(void* p) const;
+    };
+    std::unique_ptr<void, RingFree> storage_;
+    float* ring_ = nullptr;        // FLOAT32 view of storage_
+    int16_t* ring_i16_ = nullptr;  // INT16 view of storage_
+
+    // Producer-side bookkeeping for returning consumed pages to the OS
+    size_t page_size_ = 4096;
+    uint64_t released_pos_ = 0;
+
+    // Absolute stream positions (total samples ever written / consumed)
+    std::atomic<uint64_t> write_pos_{0};
+    std::atomic<uint64_t> read_pos_{0};
+
+    // Oldest readable position given a published write position
+    uint64_t startPos(uint64_t write_pos) const;
+
+    // Copy [from, from + count) out of the ring as float32, then discard any prefix
+    // the producer overwrote, or the consumer consumed (and the producer may have
+    // released), meanwhile. Returns the number of leading samples dropped.
+    size_t copyOut(uint64_t from, size_t count, float* out) const;
+
+    // Write count samples to the ring; store(ring_index, src_offset, n) fills
+    // n contiguous slots starting at ring_index
+    template <typename Store>
+    void write(size_t count, Store store);
 
-    // Convert int16 to float32 (normalized to [-1, 1])
-    static float int16ToFloat(int16_t sample) {
-        return static_cast<float>(sample) / 32768.0f;
-    }
+    // Producer only: release whole pages behind the read cursor
+    void releaseConsumed(uint64_t write_pos);
 };
 
 #endif // AUDIO_BUFFER_HPP
@@ -41,15 +41,33 @@ void printUsage(const char* prog) {
               << "      --host ADDRESS    Bind address (default: 0.0.0.0)\n"
               << "      --token SECRET    Authentication token for WebSocket connections\n"
               << "  -c, --contexts N      Number of parallel contexts (default: 2)\n"
+              << "      --min-contexts N  Contexts kept loaded; more are created while sessions wait (default: all)\n"
+              << "      --context-idle MS Free a context above --min-contexts after MS unused (default: 60000)\n"
+              << "      --pool-mb MB      Memory budget for contexts; caps --contexts (default: 0 = none)\n"
+              << "      --context-mb MB   Memory per context for --pool-mb (default: measured)\n"
+              << "      --workers N       Concurrent decodes, finals first (default: one per context)\n"
               << "  -t, --threads N       Threads per inference (default: 4)\n"
               << "  -l, --language LANG   Language code (default: en)\n"
               << "      --step MS         Inference step interval in ms (default: 500)\n"
+              << "      --max-step MS     Partial interval ceiling under load (default: 2000, <= step disables)\n"
               << "      --length MS       Audio context length in ms (default: 5000)\n"
               << "      --keep MS         Audio overlap in ms (default: 200)\n"
+              << "      --commit MS       Commit audio leaving the window in chunks of MS (default: 5000, 0 = off)\n"
+              << "      --partial-audio-ctx  Size partial encoder context to the window (faster on CPU)\n"
+              << "      --audio-ctx-margin MS  Extra context for --partial-audio-ctx (default: 1000)\n"
               << "      --no-gpu          Disable GPU acceleration\n"
               << "      --translate       Translate to English\n"
+              << "      --no-final-reuse  Always re-decode for finals, even if the last partial covers it\n"
+              << "      --no-local-agreement  Re-decode the whole window each partial, no stable prefix\n"
+              << "      --no-warmup       Skip the warm-up decode on each new context\n"
               << "      --vad-threshold N Speech probability threshold 0.0-1.0 (default: 0.5)\n"
               << "      --vad-silence MS  Silence duration to trigger final (default: 1000)\n"
+              << "      --priority-aging MS  Head start per ?priority= class when waiting for a context (default: 5000)\n"
+              << "      --priority-token SECRET  Honor ?priority= only with &priority_token=SECRET (default: off, all normal)\n"
+              << "      --speculative-final MS  Start decoding the final on a spare context after MS of silence (default: 0 = off)\n"
+              << "      --vad-preroll MS  Audio kept before speech onset while idle (default: 400)\n"
+              << "      --no-vad-stream   Re-check the last 30ms each VAD tick instead of only new audio\n"
+              << "      --vad-contexts N  VAD threads, one VAD context each (default: 2)\n"
               << "  -h, --help            Show this help\n"
               << std::endl;
 }
@@ -71,6 +89,9 @@ bool parseArgs(int argc, char** argv, ServerConfig& config) {
         else if ((arg == "-c" || arg == "--contexts") && i + 1 < argc) {
             config.n_contexts = std::stoi(argv[++i]);
         }
+        else if (arg == "--workers" && i + 1 < argc) {
+            config.n_workers = std::stoi(argv[++i]);
+        }
         else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) {
             config.n_threads = std::stoi(argv[++i]);
         }
@@ -80,15 +101,36 @@ bool parseArgs(int argc, char** argv, ServerConfig& config) {
         else if (arg == "--step" && i + 1 < argc) {
             config.step_ms = std::stoi(argv[++i]);
         }
+        else if (arg == "--max-step" && i + 1 < argc) {
+            config.max_step_ms = std::stoi(argv[++i]);
+        }
         else if (arg == "--length" && i + 1 < argc) {
             config.length_ms = std::stoi(argv[++i]);
         }
         else if (arg == "--keep" && i + 1 < argc) {
             config.keep_ms = std::stoi(argv[++i]);
         }
+        else if (arg == "--commit" && i + 1 < argc) {
+            config.commit_ms = std::stoi(argv[++i]);
+        }
+        else if (arg == "--partial-audio-ctx") {
+            config.partial_audio_ctx = true;
+        }
+        else if (arg == "--audio-ctx-margin" && i + 1 < argc) {
+            config.audio_ctx_margin_ms = std::stoi(argv[++i]);
+        }
         else if (arg == "--no-gpu") {
             config.use_gpu = false;
         }
+        else if (arg == "--no-warmup") {
+            config.warmup = false;
+        }
+        else if (arg == "--no-final-reuse") {
+            config.reuse_partial_final = false;
+        }
+        else if (arg == "--no-local-agreement") {
+            config.local_agreement = false;
+        }
         else if (arg == "--translate") {
             config.translate = true;
         }
@@ -101,12 +143,42 @@ bool parseArgs(int argc, char** argv, ServerConfig& config) {
         else if (arg == "--vad-silence" && i + 1 < argc) {
             config.silence_trigger_ms = std::stoi(argv[++i]);
         }
+        else if (arg == "--min-contexts" && i + 1 < argc) {
+            config.min_contexts = std::stoi(argv[++i]);
+        }
+        else if (arg == "--context-idle" && i + 1 < argc) {
+            config.context_idle_ms = std::stoi(argv[++i]);
+        }
+        else if (arg == "--pool-mb" && i + 1 < argc) {
+            config.pool_mb = std::stoi(argv[++i]);
+        }
+        else if (arg == "--context-mb" && i + 1 < argc) {
+            config.context_mb = std::stoi(argv[++i]);
+        }
+        else if (arg == "--priority-aging" && i + 1 < argc) {
+            config.admission_aging_ms = std::stoi(argv[++i]);
+        }
+        else if (arg == "--speculative-final" && i + 1 < argc) {
+            config.speculative_final_ms = std::stoi(argv[++i]);
+        }
+        else if (arg == "--vad-preroll" && i + 1 < argc) {
+            config.vad_preroll_ms = std::stoi(argv[++i]);
+        }
+        else if (arg == "--no-vad-stream") {
+            config.vad_streaming = false;
+        }
+        else if (arg == "--vad-contexts" && i + 1 < argc) {
+            config.n_vad_contexts = std::stoi(argv[++i]);
+        }
         else if (arg == "--host" && i + 1 < argc) {
             config.host = argv[++i];
         }
         else if (arg == "--token" && i + 1 < argc) {
             config.auth_token = argv[++i];
         }
+        else if (arg == "--priority-token" && i + 1 < argc) {
+            config.priority_token = argv[++i];
+        }
         else {
             std::cerr << "Unknown argument: " << arg << std::endl;
             printUsage(argv[0]);
@@ -120,6 +192,11 @@ bool parseArgs(int argc, char** argv, ServerConfig& config) {
         printUsage(argv[0]);
         return false;
     }
+    if (config.n_contexts < 1) {
+        std::cerr << "Error: --contexts must be at least 1\n" << std::endl;
+        printUsage(argv[0]);
+        return false;
+    }
 
     return true;
 }
@@ -138,6 +215,7 @@ std::string getQueryParam(std::string_view query, const std::string& param) {
 // Per-socket user data
 struct PerSocketData {
     std::string session_id;
+    int priority = AdmissionQueue::NORMAL;  // ?priority=low|normal|high
 };
 
 int main(int argc, char** argv) {
@@ -165,6 +243,16 @@ int main(int argc, char** argv) {
 
     // Create uWebSockets app
     uWS::App()
+        .get("/metrics", [&config, &server](auto* res, auto* req) {
+            // Same token as WebSocket connections, if configured
+            if (!config.auth_token.empty() && getQueryParam(req->getQuery(), "token") != config.auth_token) {
+                res->writeStatus("401 Unauthorized");
+                res->end("Invalid or missing token");
+                return;
+            }
+            res->writeHeader("Content-Type", "application/json");
+            res->end(server.makeMetricsJson());
+        })
         .ws<PerSocketData>("/*", {
             // Settings
             .compression = uWS::DISABLED,
@@ -184,9 +272,17 @@ int main(int argc, char** argv) {
                     }
                 }
 
+                // The admission class is the server's call: a client may only pick
+                // one with the priority token, everyone else queues as NORMAL
+                int priority = AdmissionQueue::NORMAL;
+                if (!config.priority_token.empty() &&
+                    getQueryParam(req->getQuery(), "priority_token") == config.priority_token) {
+                    priority = AdmissionQueue::parsePriority(getQueryParam(req->getQuery(), "priority"));
+                }
+
                 // Accept the upgrade
                 res->template upgrade<PerSocketData>(
-                    { .session_id = "" },
+                    { .session_id = "", .priority = priority },
                     req->getHeader("sec-websocket-key"),
                     req->getHeader("sec-websocket-protocol"),
                     req->getHeader("sec-websocket-extensions"),
@@ -205,7 +301,7 @@ int main(int argc, char** argv) {
                 std::cout << "[whisper-server] WebSocket connected: " << session_id << std::endl;
 
                 // Create the session (no send callback - we use message queue now)
-                auto session = server.createSession(session_id);
+                auto session = server.createSession(session_id, data->priority);
 
                 if (!session) {
                     ws->send(R"({"type":"error","message":"No available contexts, try again later"})",
@@ -0,0 +1,125 @@
+#include "pcm_convert.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PCM_CONVERT_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define PCM_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+static constexpr float kInt16Scale = 1.0f / 32768.0f;  // 2^-15, exact
+
+void pcmInt16ToFloatScalar(const int16_t* src, float* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]) * kInt16Scale;
+    }
+}
+
+#if PCM_CONVERT_X86
+
+__attribute__((target("sse2")))
+static void convertSse2(const int16_t* src, float* dst, size_t count) {
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // Sign-extend by placing each int16 in the high half of an int32, then shifting down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    pcmInt16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void convertAvx2(const int16_t* src, float* dst, size_t count) {
+    const __m256 scale = _mm256_set1_ps(kInt16Scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), scale));
+    }
+    pcmInt16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void convertAvx512(const int16_t* src, float* dst, size_t count) {
+    const __m512 scale = _mm512_set1_ps(kInt16Scale);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(a)), scale));
+        _mm512_storeu_ps(dst + i + 16, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(b)), scale));
+    }
+    pcmInt16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+#endif // PCM_CONVERT_X86
+
+#if PCM_CONVERT_NEON
+
+static void convertNeon(const int16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        int16x8_t a = vld1q_s16(src + i);
+        int16x8_t b = vld1q_s16(src + i + 8);
+        vst1q_f32(dst + i,      vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(a))), kInt16Scale));
+        vst1q_f32(dst + i + 4,  vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(a))), kInt16Scale));
+        vst1q_f32(dst + i + 8,  vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(b))), kInt16Scale));
+        vst1q_f32(dst + i + 12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(b))), kInt16Scale));
+    }
+    pcmInt16ToFloatScalar(src + i, dst + i, count - i);
+}
+
+#endif // PCM_CONVERT_NEON
+
+static const PcmConvertKernel kScalarKernel = {"scalar", pcmInt16ToFloatScalar};
+#if PCM_CONVERT_X86
+static const PcmConvertKernel kSse2Kernel = {"sse2", convertSse2};
+static const PcmConvertKernel kAvx2Kernel = {"avx2", convertAvx2};
+static const PcmConvertKernel kAvx512Kernel = {"avx512", convertAvx512};
+#endif
+#if PCM_CONVERT_NEON
+static const PcmConvertKernel kNeonKernel = {"neon", convertNeon};
+#endif
+
+size_t pcmSupportedKernels(const PcmConvertKernel** out, size_t max_kernels) {
+    size_t n = 0;
+    auto add = [&](const PcmConvertKernel& kernel) {
+        if (n < max_kernels) out[n++] = &kernel;
+    };
+
+    add(kScalarKernel);
+#if PCM_CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) add(kSse2Kernel);
+    if (__builtin_cpu_supports("avx2")) add(kAvx2Kernel);
+    if (__builtin_cpu_supports("avx512f")) add(kAvx512Kernel);
+#endif
+#if PCM_CONVERT_NEON
+    add(kNeonKernel);
+#endif
+    return n;
+}
+
+const PcmConvertKernel& pcmActiveKernel() {
+    // Kernels are listed slowest to fastest; resolved once (thread-safe static init)
+    static const PcmConvertKernel& active = []() -> const PcmConvertKernel& {
+        const PcmConvertKernel* kernels[8];
+        size_t n = pcmSupportedKernels(kernels, 8);
+        return *kernels[n - 1];
+    }();
+    return active;
+}
+
+void pcmInt16ToFloat(const int16_t* src, float* dst, size_t count) {
+    static const auto convert = pcmActiveKernel().convert;
+    convert(src, dst, count);
+}
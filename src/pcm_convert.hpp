@@ -0,0 +1,31 @@
+#ifndef PCM_CONVERT_HPP
+#define PCM_CONVERT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// int16 PCM -> float32 conversion: dst[i] = src[i] / 32768.0f
+//
+// The vectorized kernels scale by 2^-15, which is exact for every int16 value,
+// so all kernels produce bit-identical output to the scalar reference.
+// The fastest kernel supported by the running CPU is picked once, on first use.
+
+// A conversion kernel and its name (for logging and tests)
+struct PcmConvertKernel {
+    const char* name;
+    void (*convert)(const int16_t* src, float* dst, size_t count);
+};
+
+// Convert using the kernel selected for this CPU
+void pcmInt16ToFloat(const int16_t* src, float* dst, size_t count);
+
+// Scalar reference implementation
+void pcmInt16ToFloatScalar(const int16_t* src, float* dst, size_t count);
+
+// Kernel used by pcmInt16ToFloat()
+const PcmConvertKernel& pcmActiveKernel();
+
+// Every kernel this build contains that the running CPU supports (scalar first)
+size_t pcmSupportedKernels(const PcmConvertKernel** out, size_t max_kernels);
+
+#endif // PCM_CONVERT_HPP
@@ -1,4 +1,5 @@
 #include "whisper_server.hpp"
+#include "pcm_convert.hpp"
 #include "json.hpp"
 
 #include <App.h>  // For uWS::Loop and WebSocket types
@@ -8,16 +9,77 @@
 #include <sstream>
 #include <iomanip>
 #include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
 
 using json = nlohmann::json;
 
 // Forward declaration of per-socket data (matches main.cpp)
 struct PerSocketData {
     std::string session_id;
+    int priority = AdmissionQueue::NORMAL;
 };
 
-// Callback to disable whisper internal logging (for VAD spam)
-static void whisper_log_disable(enum ggml_log_level, const char*, void*) {}
+// Silero VAD window at 16kHz (whisper_vad_detect_speech() pads partial windows)
+static const size_t kVadWindowSamples = 512;
+
+// Committed tokens carried into the next partial as its prompt (whisper keeps at
+// most n_text_ctx / 2 = 224 prompt tokens)
+static const size_t kPromptTokens = 128;
+
+// Set on a thread while it runs VAD, to silence whisper's per-call logging (VAD spam)
+static thread_local bool t_whisper_log_quiet = false;
+
+// Whisper log callback, installed once: same output as whisper's default
+// (stderr) unless the calling thread is inside a VAD call
+static void whisper_log_filter(enum ggml_log_level, const char* text, void*) {
+    if (t_whisper_log_quiet) return;
+    fputs(text, stderr);
+    fflush(stderr);
+}
+
+// Monotonic milliseconds (same clock as VAD timestamps and scheduler deadlines)
+static int64_t steadyNowMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// whisper's abort callback: true once the job's result is no longer wanted
+static bool jobAbortCallback(void* data) {
+    return static_cast<const JobCancel*>(data)->cancelled();
+}
+
+// Memory the process currently holds, for sizing the pool against pool_mb
+// (0 if unknown). On Apple this is the physical footprint, which includes Metal
+// buffers in unified memory.
+static size_t residentBytes() {
+#if defined(__APPLE__)
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return static_cast<size_t>(info.phys_footprint);
+    }
+    return 0;
+#elif defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0, resident_pages = 0;
+    if (statm >> total_pages >> resident_pages) {
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
 
 // Generate a random session ID
 static std::string generateSessionId() {
@@ -34,61 +96,177 @@ static std::string generateSessionId() {
     return id;
 }
 
+// Encoder context (in 20ms mel frames) needed for a partial of n_samples.
+// Adds margin_ms, rounds up to a multiple of 64 frames and never goes below
+// kMinAudioCtx, since very short contexts make whisper prone to hallucination.
+// Returns 0 (use the model's full context) when the saving would be small.
+static int partialAudioCtx(size_t n_samples, int margin_ms, int n_audio_ctx) {
+    static const int kMsPerFrame = 20;
+    static const int kFrameAlign = 64;
+    static const int kMinAudioCtx = 256;  // ~5s
+
+    int ms = static_cast<int>((n_samples * 1000) / WHISPER_SAMPLE_RATE) + margin_ms;
+    int frames = (ms + kMsPerFrame - 1) / kMsPerFrame;
+    frames = (frames + kFrameAlign - 1) / kFrameAlign * kFrameAlign;
+    frames = std::max(frames, kMinAudioCtx);
+
+    return frames * 4 >= n_audio_ctx * 3 ? 0 : frames;
+}
+
+// Join two pieces of transcript with a single space
+static std::string joinText(const std::string& a, const std::string& b) {
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+    return a + " " + b;
+}
+
+// Trim surrounding whitespace from decoded text
+static std::string trimText(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\n\r");
+    size_t end = text.find_last_not_of(" \t\n\r");
+    if (start == std::string::npos || end == std::string::npos) {
+        return "";
+    }
+    return text.substr(start, end - start + 1);
+}
+
 WhisperServer::WhisperServer(const ServerConfig& config)
-    : config_(config) {
+    : config_(config)
+    , reuse_partial_final_(config.reuse_partial_final && !config.partial_audio_ctx)
+    , admission_queue_(config.admission_aging_ms) {
+    effective_step_ms_ = config_.step_ms;
 }
 
 WhisperServer::~WhisperServer() {
     stop();
 
-    // Free all whisper contexts
+    // Free per-slot states, then the shared model
     for (auto& slot : context_pool_) {
-        if (slot && slot->ctx) {
-            whisper_free(slot->ctx);
-            slot->ctx = nullptr;
+        if (slot && slot->state) {
+            whisper_free_state(slot->state);
+            slot->state = nullptr;
         }
     }
 
-    // Free VAD context
-    if (vad_ctx_) {
-        whisper_vad_free(vad_ctx_);
-        vad_ctx_ = nullptr;
+    if (model_ctx_) {
+        whisper_free(model_ctx_);
+        model_ctx_ = nullptr;
+    }
+
+    // Free VAD contexts
+    for (auto* vad_ctx : vad_pool_) {
+        whisper_vad_free(vad_ctx);
     }
+    vad_pool_.clear();
+    vad_free_.clear();
 }
 
 bool WhisperServer::init() {
+    int64_t init_start_ms = steadyNowMs();
     std::cout << "[whisper-server] Initializing with " << config_.n_contexts
               << " context(s)..." << std::endl;
     std::cout << "[whisper-server] Model: " << config_.model_path << std::endl;
     std::cout << "[whisper-server] GPU: " << (config_.use_gpu ? "enabled" : "disabled") << std::endl;
+    std::cout << "[whisper-server] PCM conversion kernel: " << pcmActiveKernel().name << std::endl;
 
     // Load the backend
     ggml_backend_load_all();
 
-    // Initialize context pool
+    // Route whisper logging through a filter that VAD calls can mute per thread
+    whisper_log_set(whisper_log_filter, nullptr);
+
+    // Load model weights once; every slot shares them
     whisper_context_params cparams = whisper_context_default_params();
     cparams.use_gpu = config_.use_gpu;
     cparams.flash_attn = config_.flash_attn;
 
-    for (int i = 0; i < config_.n_contexts; ++i) {
-        std::cout << "[whisper-server] Loading context " << (i + 1) << "/" << config_.n_contexts << "..." << std::endl;
+    model_ctx_ = whisper_init_from_file_with_params_no_state(
+        config_.model_path.c_str(), cparams
+    );
 
-        auto slot = std::make_unique<ContextSlot>();
-        slot->ctx = whisper_init_from_file_with_params(
-            config_.model_path.c_str(), cparams
-        );
+    if (!model_ctx_) {
+        std::cerr << "[whisper-server] Failed to load model" << std::endl;
+        return false;
+    }
+    model_load_ms_ = steadyNowMs() - init_start_ms;
+    std::cout << "[whisper-server] Model loaded in " << model_load_ms_ << "ms" << std::endl;
 
-        if (!slot->ctx) {
-            std::cerr << "[whisper-server] Failed to load model for context " << i << std::endl;
-            return false;
-        }
+    if (config_.n_contexts < 1) {
+        std::cerr << "[whisper-server] At least one context is required" << std::endl;
+        return false;
+    }
 
+    // Slots for the whole ceiling; states (the expensive part) only for the minimum
+    for (int i = 0; i < config_.n_contexts; ++i) {
+        auto slot = std::make_unique<ContextSlot>();
         slot->slot_id = i;
-        slot->in_use = false;
         context_pool_.push_back(std::move(slot));
     }
+    free_slot_words_ = (context_pool_.size() + 63) / 64;
+    free_slots_ = std::make_unique<std::atomic<uint64_t>[]>(free_slot_words_);
+
+    int n_slots = static_cast<int>(context_pool_.size());
+    min_live_ = config_.min_contexts > 0 ? std::min(config_.min_contexts, n_slots) : n_slots;
+    max_live_ = n_slots;
+
+    // The first state also tells us what one costs, unless configured, so it is
+    // created alone
+    int64_t contexts_start_ms = steadyNowMs();
+    size_t before = residentBytes();
+    std::cout << "[whisper-server] Creating context 1/" << min_live_ << "..." << std::endl;
+    if (!createSlotState(context_pool_[0].get())) {
+        return false;
+    }
+    size_t after = residentBytes();
+    context_bytes_ = config_.context_mb > 0 ? static_cast<size_t>(config_.context_mb) << 20
+                                            : (after > before ? after - before : 0);
+
+    if (config_.pool_mb > 0) {
+        if (context_bytes_ > 0) {
+            size_t budget = static_cast<size_t>(config_.pool_mb) << 20;
+            max_live_ = static_cast<int>(std::clamp<size_t>(budget / context_bytes_, 1, n_slots));
+            min_live_ = std::min(min_live_, max_live_);
+        } else {
+            std::cerr << "[whisper-server] Warning: can't measure context memory, --pool-mb ignored"
+                      << " (set --context-mb)" << std::endl;
+        }
+    }
 
-    std::cout << "[whisper-server] All contexts loaded successfully" << std::endl;
+    // The rest are independent: create and warm them concurrently, with only as
+    // many loaders as the cores can run warm-up decodes for
+    int n_loaders = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / std::max(1, config_.n_threads),
+                               1, std::max(1, min_live_ - 1));
+    std::atomic<int> next_slot{1};
+    std::atomic<bool> load_failed{false};
+    std::vector<std::thread> loaders;
+    for (int t = 0; t < n_loaders && min_live_ > 1; ++t) {
+        loaders.emplace_back([this, &next_slot, &load_failed] {
+            for (int i = next_slot++; i < min_live_ && !load_failed; i = next_slot++) {
+                if (!createSlotState(context_pool_[i].get())) {
+                    load_failed = true;
+                }
+            }
+        });
+    }
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    if (load_failed) {
+        return false;  // The destructor frees the states that were created
+    }
+    contexts_ready_ms_ = steadyNowMs() - contexts_start_ms;
+
+    // Every live slot starts free
+    for (int i = 0; i < min_live_; ++i) {
+        free_slots_[i / 64].fetch_or(uint64_t{1} << (i % 64), std::memory_order_relaxed);
+    }
+
+    std::cout << "[whisper-server] All contexts loaded successfully in " << contexts_ready_ms_ << "ms (~"
+              << (context_bytes_ >> 20) << " MB each, " << n_loaders << " loader thread(s))" << std::endl;
+    if (max_live_ > min_live_) {
+        std::cout << "[whisper-server] Elastic pool: " << min_live_ << "-" << max_live_
+                  << " contexts, idle timeout " << config_.context_idle_ms << "ms" << std::endl;
+    }
 
     // Load VAD model (optional)
     if (!config_.vad_model_path.empty()) {
@@ -98,29 +276,73 @@ bool WhisperServer::init() {
         vad_params.n_threads = 2;
         vad_params.use_gpu = false;  // VAD is lightweight, CPU is fine
 
-        vad_ctx_ = whisper_vad_init_from_file_with_params(
-            config_.vad_model_path.c_str(), vad_params);
+        // One context per concurrent VAD check (the LSTM state lives in the
+        // context, but whisper_vad_detect_speech() resets it on every call)
+        int n_vad_contexts = std::max(1, config_.n_vad_contexts);
+        for (int i = 0; i < n_vad_contexts; ++i) {
+            whisper_vad_context* vad_ctx = whisper_vad_init_from_file_with_params(
+                config_.vad_model_path.c_str(), vad_params);
 
-        if (!vad_ctx_) {
-            std::cerr << "[whisper-server] Failed to load VAD model" << std::endl;
-            return false;
+            if (!vad_ctx) {
+                std::cerr << "[whisper-server] Failed to load VAD model" << std::endl;
+                return false;
+            }
+            vad_pool_.push_back(vad_ctx);
         }
-        std::cout << "[whisper-server] VAD enabled (threshold=" << config_.vad_threshold
-                  << ", silence=" << config_.silence_trigger_ms << "ms)" << std::endl;
+        vad_free_ = vad_pool_;
+
+        std::cout << "[whisper-server] VAD enabled (" << vad_pool_.size()
+                  << " context(s), threshold=" << config_.vad_threshold
+                  << ", silence=" << config_.silence_trigger_ms << "ms, "
+                  << (config_.vad_streaming ? "streaming" : "last " + std::to_string(config_.vad_check_ms) + "ms")
+                  << ")" << std::endl;
     }
 
+    startup_ms_ = steadyNowMs() - init_start_ms;
+    std::cout << "[whisper-server] Ready in " << startup_ms_ << "ms (model " << model_load_ms_
+              << "ms, contexts " << contexts_ready_ms_ << "ms)" << std::endl;
     return true;
 }
 
 void WhisperServer::run() {
     running_ = true;
 
-    // Start inference loop thread
+    // Start one inference worker per context that can be live so leased contexts run
+    // in parallel (--workers can cap decode concurrency below that; jobs then queue
+    // by priority)
+    size_t n_workers = static_cast<size_t>(max_live_);
+    if (config_.n_workers > 0) {
+        n_workers = std::min(n_workers, static_cast<size_t>(config_.n_workers));
+    }
+    for (size_t i = 0; i < n_workers; ++i) {
+        worker_threads_.emplace_back(&WhisperServer::workerLoop, this);
+    }
+
+    // Start VAD threads (one per VAD context) so VAD never waits on the decoder
+    for (size_t i = 0; i < vad_pool_.size(); ++i) {
+        vad_threads_.emplace_back(&WhisperServer::vadLoop, this, static_cast<int>(i));
+    }
+
+    // Start inference loop thread (job scheduling)
     inference_thread_ = std::thread(&WhisperServer::inferenceLoop, this);
 
+    // Grow and shrink the pool only if it has room to
+    if (max_live_ > min_live_) {
+        pool_thread_ = std::thread(&WhisperServer::poolLoop, this);
+    }
+
     std::cout << "[whisper-server] Server running on port " << config_.port << std::endl;
+    std::cout << "[whisper-server] Workers: " << worker_threads_.size()
+              << " x " << config_.n_threads << " thread(s), VAD threads: " << vad_threads_.size() << std::endl;
     std::cout << "[whisper-server] Inference: step=" << config_.step_ms << "ms, length="
               << config_.length_ms << "ms, keep=" << config_.keep_ms << "ms" << std::endl;
+    if (config_.max_step_ms > config_.step_ms) {
+        std::cout << "[whisper-server] Adaptive step: up to " << config_.max_step_ms << "ms under load" << std::endl;
+    }
+    if (config_.partial_audio_ctx) {
+        std::cout << "[whisper-server] Partial audio_ctx: window + " << config_.audio_ctx_margin_ms
+                  << "ms margin" << std::endl;
+    }
 }
 
 void WhisperServer::stop() {
@@ -128,10 +350,53 @@ void WhisperServer::stop() {
 
     running_ = false;
 
+    // Wake the scheduler and idle VAD threads (taking each lock so a thread
+    // about to wait can't miss the notification)
+    { std::lock_guard<std::mutex> lock(sched_mutex_); }
+    sched_cv_.notify_all();
+    { std::lock_guard<std::mutex> lock(sessions_mutex_); }
+    sessions_cv_.notify_all();
+    { std::lock_guard<std::mutex> lock(pool_mutex_); }
+    pool_cv_.notify_all();
+
+    if (pool_thread_.joinable()) {
+        pool_thread_.join();
+    }
+
     if (inference_thread_.joinable()) {
         inference_thread_.join();
     }
 
+    for (auto& vad_thread : vad_threads_) {
+        if (vad_thread.joinable()) {
+            vad_thread.join();
+        }
+    }
+    vad_threads_.clear();
+
+    // Wake and join workers (each finishes its current job first)
+    job_cv_.notify_all();
+    for (auto& worker : worker_threads_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    worker_threads_.clear();
+
+    // Drop jobs that never started
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        while (!job_queue_.empty()) {
+            const InferenceJob& job = job_queue_.top();
+            if (job.type == JobType::SPECULATIVE) {
+                releaseContext(job.slot);
+            } else {
+                job.session->inference_running = false;
+            }
+            job_queue_.pop();
+        }
+    }
+
     // Clean up sessions
     std::lock_guard<std::mutex> lock(sessions_mutex_);
     for (auto& [id, session] : sessions_) {
@@ -143,38 +408,314 @@ void WhisperServer::stop() {
     sessions_.clear();
 }
 
-ContextSlot* WhisperServer::acquireContext() {
-    std::lock_guard<std::mutex> lock(context_pool_mutex_);
-    for (auto& slot : context_pool_) {
-        if (!slot->in_use) {
-            slot->in_use = true;
+ContextSlot* WhisperServer::claimFreeSlot() {
+    // Lowest set bit of the first non-empty word; the CAS retries only if another
+    // thread claimed or freed a slot in the same word meanwhile
+    for (size_t w = 0; w < free_slot_words_; ++w) {
+        uint64_t bits = free_slots_[w].load(std::memory_order_relaxed);
+        while (bits != 0) {
+            uint64_t lowest = bits & (~bits + 1);
+            if (free_slots_[w].compare_exchange_weak(bits, bits & ~lowest, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+                ContextSlot* slot = context_pool_[w * 64 + __builtin_ctzll(lowest)].get();
+                beginLease(slot);
+                return slot;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void WhisperServer::beginLease(ContextSlot* slot) {
+    slot->leased_at_ms.store(steadyNowMs(), std::memory_order_relaxed);
+    slot->lease_count.fetch_add(1, std::memory_order_relaxed);
+    contexts_in_use_++;
+}
+
+int64_t WhisperServer::endLease(ContextSlot* slot) {
+    int64_t held_ms = steadyNowMs() - slot->leased_at_ms.exchange(0, std::memory_order_relaxed);
+    slot->lease_ms_total.fetch_add(static_cast<uint64_t>(held_ms), std::memory_order_relaxed);
+    int64_t longest = slot->lease_ms_max.load(std::memory_order_relaxed);
+    while (held_ms > longest &&
+           !slot->lease_ms_max.compare_exchange_weak(longest, held_ms, std::memory_order_relaxed)) {
+    }
+    contexts_in_use_--;
+    return held_ms;
+}
+
+std::pair<std::string, int64_t> WhisperServer::grantLocked(ContextSlot* slot) {
+    int64_t now_ms = steadyNowMs();
+    AdmissionQueue::Waiter waiter = admission_queue_.pop(now_ms);
+    int64_t waited_ms = now_ms - waiter.enqueued_ms;
+
+    admission_grants_[waiter.id] = slot;
+    admissions_++;
+    admission_wait_ms_total_ += waited_ms;
+    admission_wait_ms_worst_ = std::max(admission_wait_ms_worst_, waited_ms);
+    return {waiter.id, waited_ms};
+}
+
+ContextSlot* WhisperServer::acquireContext(const Session& session, bool wait) {
+    // Fast path, no lock: with nobody queued or holding a grant, a free slot is anyone's
+    if (admission_pending_.load(std::memory_order_acquire) == 0) {
+        if (ContextSlot* slot = claimFreeSlot()) {
             std::cout << "[whisper-server] Acquired context slot " << slot->slot_id << std::endl;
-            return slot.get();
+            return slot;
         }
     }
-    return nullptr; // All contexts busy
+    if (!wait) {
+        return nullptr;  // Never take a slot a queued session is due
+    }
+
+    ContextSlot* slot = nullptr;
+    bool queued = false;
+    size_t n_waiting = 0;
+    std::vector<std::pair<int, std::pair<std::string, int64_t>>> handoffs;
+    {
+        std::lock_guard<std::mutex> lock(admission_mutex_);
+
+        // A slot freed while nobody seemed to be waiting goes to the queue, in order
+        while (!admission_queue_.empty()) {
+            ContextSlot* free_slot = claimFreeSlot();
+            if (!free_slot) break;
+            handoffs.push_back({free_slot->slot_id, grantLocked(free_slot)});
+        }
+
+        // A slot released while we waited was handed straight to us
+        auto grant = admission_grants_.find(session.id);
+        if (grant != admission_grants_.end()) {
+            slot = grant->second;
+            admission_grants_.erase(grant);
+        } else if (admission_queue_.empty()) {
+            slot = claimFreeSlot();
+        }
+
+        if (!slot) {
+            queued = admission_queue_.push(session.id, session.priority, steadyNowMs());
+        }
+        n_waiting = admission_queue_.size();
+        admission_pending_.store(static_cast<int>(n_waiting + admission_grants_.size()),
+                                 std::memory_order_release);
+    }
+
+    for (const auto& [slot_id, handoff] : handoffs) {
+        std::cout << "[whisper-server] Handed context slot " << slot_id << " to session "
+                  << handoff.first << " (waited " << handoff.second << "ms)" << std::endl;
+    }
+    if (queued) {
+        std::cout << "[whisper-server] Session " << session.id << " queued for a context ("
+                  << n_waiting << " waiting)" << std::endl;
+        requestPoolGrowth();
+    }
+    return slot;
 }
 
 void WhisperServer::releaseContext(ContextSlot* slot) {
-    if (slot) {
-        std::lock_guard<std::mutex> lock(context_pool_mutex_);
-        std::cout << "[whisper-server] Released context slot " << slot->slot_id << std::endl;
-        slot->in_use = false;
+    if (!slot) return;
+
+    int64_t held_ms = endLease(slot);
+    std::cout << "[whisper-server] Released context slot " << slot->slot_id
+              << " (held " << held_ms << "ms)" << std::endl;
+    offerSlot(slot);
+}
+
+void WhisperServer::offerSlot(ContextSlot* slot) {
+    // Hand the slot to the next waiter instead of back to the pool, so it can't
+    // be taken by whichever session happens to ask first
+    if (admission_pending_.load(std::memory_order_acquire) > 0) {
+        std::pair<std::string, int64_t> handoff;
+        bool handed = false;
+        {
+            std::lock_guard<std::mutex> lock(admission_mutex_);
+            if (!admission_queue_.empty()) {
+                beginLease(slot);
+                handoff = grantLocked(slot);
+                handed = true;
+                admission_pending_.store(static_cast<int>(admission_queue_.size() + admission_grants_.size()),
+                                         std::memory_order_release);
+            }
+        }
+        if (handed) {
+            std::cout << "[whisper-server] Handed context slot " << slot->slot_id << " to session "
+                      << handoff.first << " (waited " << handoff.second << "ms)" << std::endl;
+            return;
+        }
+    }
+
+    // A session that queued just after we checked picks this up on its next
+    // VAD tick (acquireContext() hands stranded free slots to the queue)
+    slot->released_at_ms.store(steadyNowMs(), std::memory_order_relaxed);
+    free_slots_[slot->slot_id / 64].fetch_or(uint64_t{1} << (slot->slot_id % 64), std::memory_order_release);
+}
+
+bool WhisperServer::claimSlot(ContextSlot* slot) {
+    uint64_t bit = uint64_t{1} << (slot->slot_id % 64);
+    std::atomic<uint64_t>& word = free_slots_[slot->slot_id / 64];
+    uint64_t bits = word.load(std::memory_order_relaxed);
+    while (bits & bit) {
+        if (word.compare_exchange_weak(bits, bits & ~bit, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WhisperServer::createSlotState(ContextSlot* slot) {
+    // Called from init()'s loader threads and the pool thread; touches only this slot
+    int64_t start_ms = steadyNowMs();
+    slot->state = whisper_init_state(model_ctx_);
+    if (!slot->state) {
+        std::cerr << "[whisper-server] Failed to create state for context " << slot->slot_id << std::endl;
+        return false;
+    }
+    if (config_.warmup) {
+        warmUpState(slot->state);
+    }
+    std::cout << "[whisper-server] Context " << slot->slot_id << " ready in "
+              << (steadyNowMs() - start_ms) << "ms" << std::endl;
+    slot->released_at_ms.store(steadyNowMs(), std::memory_order_relaxed);
+    slot->live.store(true, std::memory_order_release);
+    contexts_live_++;
+    contexts_created_++;
+    return true;
+}
+
+void WhisperServer::warmUpState(whisper_state* state) {
+    // The first decode on a state pays for lazy buffer allocation and backend
+    // kernel selection (pipeline compilation on Metal). A second of silence makes
+    // that happen here rather than in a user's first partial.
+    std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+
+    whisper_full_params wparams = makeDecodeParams(nullptr);
+    wparams.single_segment = true;
+    wparams.no_context = true;
+    wparams.max_tokens = 1;
+
+    if (whisper_full_with_state(model_ctx_, state, wparams, silence.data(), silence.size()) != 0) {
+        std::cerr << "[whisper-server] Warning: warm-up decode failed" << std::endl;
     }
 }
 
-std::shared_ptr<Session> WhisperServer::createSession(const std::string& id) {
+void WhisperServer::requestPoolGrowth() {
+    if (!pool_thread_.joinable() || contexts_live_ >= max_live_) {
+        return;  // Fixed pool, or already at the ceiling
+    }
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_grow_requested_ = true;
+    }
+    pool_cv_.notify_one();
+}
+
+void WhisperServer::poolLoop() {
+    // Growth is requested as soon as a session queues; idle contexts are
+    // looked at once a second
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    while (running_) {
+        pool_cv_.wait_for(lock, std::chrono::seconds(1),
+                          [this] { return !running_ || pool_grow_requested_; });
+        if (!running_) break;
+        pool_grow_requested_ = false;
+
+        // whisper_init_state() allocates tens of MB: never under a lock
+        lock.unlock();
+        growPool();
+        shrinkPool(steadyNowMs());
+        lock.lock();
+    }
+}
+
+void WhisperServer::growPool() {
+    // One new context per queued session, up to the ceiling
+    while (running_ && contexts_live_ < max_live_) {
+        {
+            std::lock_guard<std::mutex> lock(admission_mutex_);
+            if (admission_queue_.empty()) return;
+        }
+
+        ContextSlot* slot = nullptr;
+        for (auto& candidate : context_pool_) {
+            if (!candidate->live.load(std::memory_order_acquire)) {
+                slot = candidate.get();
+                break;
+            }
+        }
+        if (!slot || !createSlotState(slot)) return;
+
+        std::cout << "[whisper-server] Created context " << slot->slot_id << " on demand ("
+                  << contexts_live_.load() << "/" << max_live_ << " live)" << std::endl;
+        offerSlot(slot);
+    }
+}
+
+void WhisperServer::shrinkPool(int64_t now_ms) {
+    // Newest slots first: claimFreeSlot() prefers low indices, so high ones idle first
+    for (auto it = context_pool_.rbegin(); it != context_pool_.rend() && contexts_live_ > min_live_; ++it) {
+        ContextSlot* slot = it->get();
+        if (!slot->live.load(std::memory_order_acquire) ||
+            now_ms - slot->released_at_ms.load(std::memory_order_relaxed) < config_.context_idle_ms) {
+            continue;
+        }
+        if (!claimSlot(slot)) {
+            continue;  // Leased (or just taken)
+        }
+
+        slot->live.store(false, std::memory_order_release);
+        whisper_free_state(slot->state);
+        slot->state = nullptr;
+        contexts_live_--;
+        contexts_freed_++;
+        std::cout << "[whisper-server] Freed idle context " << slot->slot_id << " ("
+                  << contexts_live_.load() << "/" << max_live_ << " live)" << std::endl;
+    }
+}
+
+void WhisperServer::leaveAdmissionQueue(const Session& session) {
+    ContextSlot* orphan = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(admission_mutex_);
+        admission_queue_.remove(session.id);
+
+        auto grant = admission_grants_.find(session.id);
+        if (grant != admission_grants_.end()) {
+            orphan = grant->second;
+            admission_grants_.erase(grant);
+        }
+        admission_pending_.store(static_cast<int>(admission_queue_.size() + admission_grants_.size()),
+                                 std::memory_order_release);
+    }
+
+    // Granted but never picked up: pass it on
+    if (orphan) {
+        releaseContext(orphan);
+    }
+}
+
+std::shared_ptr<Session> WhisperServer::createSession(const std::string& id, int priority) {
     // No longer acquire context here - will be leased when speech starts
     auto session = std::make_shared<Session>();
     session->id = id;
-    session->audio = std::make_unique<AudioBuffer>(30.0f, WHISPER_SAMPLE_RATE);
+    session->priority = priority;
+    // Keep raw int16 (half the memory); only windows handed to whisper/VAD get converted
+    session->audio = std::make_unique<AudioBuffer>(30.0f, WHISPER_SAMPLE_RATE,
+                                                   AudioBuffer::SampleFormat::INT16);
     session->context_slot = nullptr;  // Explicitly null - no context yet
     session->active = true;
 
+    // Golden-ratio sequence: each new session lands in the largest gap between
+    // existing phases, so partials stay spread over the step for any session count
+    static const double kGoldenFraction = 0.6180339887498949;
+    double phase = next_phase_index_++ * kGoldenFraction;
+    session->partial_phase = phase - std::floor(phase);
+    if (!vad_pool_.empty()) {
+        session->vad_shard = next_vad_shard_++ % static_cast<int>(vad_pool_.size());
+    }
+
     {
         std::lock_guard<std::mutex> lock(sessions_mutex_);
         sessions_[id] = session;
     }
+    sessions_cv_.notify_all();
 
     std::cout << "[whisper-server] Created session " << id << " (no context yet)" << std::endl;
     return session;
@@ -209,15 +750,21 @@ void WhisperServer::destroySession(const std::string& id) {
     }
 
     if (session) {
+        // Called on the event loop thread: never wait for a job here. A job in
+        // flight is aborted (see JobCancel) and its worker releases the context;
+        // the Session itself is freed when the last job or VAD pass drops it.
         session->active = false;
 
-        // Wait for any ongoing inference to complete
-        while (session->inference_running) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // The VAD thread checks active, and the worker clears inference_running,
+        // under this lock, so exactly one side releases the context
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+        leaveAdmissionQueue(*session);
+        if (!session->inference_running) {
+            releaseContext(session->context_slot);
+            session->context_slot = nullptr;
         }
-
-        releaseContext(session->context_slot);
-        std::cout << "[whisper-server] Destroyed session " << id << std::endl;
+        std::cout << "[whisper-server] Destroyed session " << id
+                  << (session->inference_running ? " (context released when its job ends)" : "") << std::endl;
     }
 }
 
@@ -234,92 +781,303 @@ void WhisperServer::onAudioReceived(const std::string& session_id, const int16_t
 
     if (session && session->active) {
         session->audio->push(data, len);
+
+        // Without VAD, audio arrival is what makes a session due for a partial
+        if (vad_pool_.empty() && session->sched_due_ms == 0 && !session->inference_running) {
+            int missing_ms = config_.step_ms - static_cast<int>(session->audio->durationMs());
+            int64_t now_ms = steadyNowMs();
+            scheduleSession(session, partialSlot(*session, now_ms + std::max(0, missing_ms), now_ms));
+        }
     }
 }
 
 void WhisperServer::inferenceLoop() {
     using namespace std::chrono;
 
-    const int vad_interval_ms = config_.vad_check_ms;      // 30ms
-    const int whisper_interval_ms = config_.step_ms;       // 500ms
-
-    auto last_vad_time = steady_clock::now();
-    auto last_whisper_time = steady_clock::now();
+    std::vector<std::shared_ptr<Session>> due;
 
     while (running_) {
-        auto now = steady_clock::now();
-        int64_t now_ms = duration_cast<milliseconds>(now.time_since_epoch()).count();
-
-        // Get snapshot of active sessions
-        std::vector<std::shared_ptr<Session>> sessions;
+        due.clear();
         {
-            std::lock_guard<std::mutex> lock(sessions_mutex_);
-            for (auto& [id, session] : sessions_) {
-                if (session->active) {
-                    sessions.push_back(session);
+            std::unique_lock<std::mutex> lock(sched_mutex_);
+
+            // Sleep until the earliest deadline, a new earlier one, or stop
+            while (running_) {
+                if (sched_heap_.empty()) {
+                    sched_cv_.wait(lock);
+                    continue;
+                }
+                int64_t due_ms = sched_heap_.top().due_ms;
+                if (due_ms <= steadyNowMs()) {
+                    break;
+                }
+                sched_cv_.wait_until(lock, steady_clock::time_point(milliseconds(due_ms)));
+            }
+
+            int64_t now_ms = steadyNowMs();
+            while (!sched_heap_.empty() && sched_heap_.top().due_ms <= now_ms) {
+                ScheduledWake wake = sched_heap_.top();
+                sched_heap_.pop();
+
+                auto session = wake.session.lock();
+                if (!session || session->sched_due_ms != wake.due_ms) {
+                    continue;  // Session gone, or superseded by an earlier deadline
                 }
+                session->sched_due_ms = 0;
+                due.push_back(std::move(session));
             }
         }
 
-        // === VAD CHECK (every 30ms) ===
-        auto vad_elapsed = duration_cast<milliseconds>(now - last_vad_time).count();
-        if (vad_ctx_ && vad_elapsed >= vad_interval_ms) {
-            for (auto& session : sessions) {
-                updateVADState(session, now_ms);
+        for (auto& session : due) {
+            serviceSession(session);
+        }
+    }
+}
+
+void WhisperServer::scheduleSession(const std::shared_ptr<Session>& session, int64_t due_ms) {
+    {
+        std::lock_guard<std::mutex> lock(sched_mutex_);
+        int64_t current = session->sched_due_ms;
+        if (current != 0 && current <= due_ms) {
+            return;  // Already due at or before this time
+        }
+        session->sched_due_ms = due_ms;
+        sched_heap_.push({due_ms, session});
+    }
+    sched_cv_.notify_one();
+}
+
+int64_t WhisperServer::partialSlot(const Session& session, int64_t due_ms, int64_t now_ms) const {
+    // Move due_ms to the nearest point of the session's own grid
+    // (phase_offset + k * step), so sessions that start together don't decode
+    // together. Shifts by at most half a step, and never into the past.
+    int64_t step = std::max(1, effective_step_ms_.load());
+    int64_t offset = static_cast<int64_t>(session.partial_phase * step);
+
+    int64_t slot = due_ms - ((due_ms - offset) % step + step) % step;
+    if (due_ms - slot > step / 2) {
+        slot += step;
+    }
+    return std::max(slot, now_ms);
+}
+
+void WhisperServer::serviceSession(const std::shared_ptr<Session>& session) {
+    // A session with a job in flight is rescheduled by the worker when it finishes
+    if (!session->active || session->inference_running) {
+        return;
+    }
+
+    // If VAD disabled, run inference once a step of audio is buffered (original
+    // behavior); the next audio arrival reschedules otherwise
+    if (vad_pool_.empty()) {
+        if (session->audio->hasMinDuration(config_.step_ms)) {
+            dispatchJob(JobType::PARTIAL, session);
+        }
+        return;
+    }
+
+    // Speech state comes from the VAD threads
+    SpeechState state;
+    bool commit_due = false;
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+        state = session->speech_state;
+        size_t commit_samples = static_cast<size_t>(config_.commit_ms) * WHISPER_SAMPLE_RATE / 1000;
+        commit_due = config_.commit_ms > 0 && session->commit_audio.size() >= commit_samples;
+    }
+
+    // If VAD enabled, only run when SPEAKING (this step's job commits slid-out
+    // audio instead of a partial once enough has built up)
+    if (state == SpeechState::SPEAKING) {
+        dispatchJob(commit_due ? JobType::COMMIT : JobType::PARTIAL, session);
+    }
+    // Handle ENDING state - emit final
+    else if (state == SpeechState::ENDING) {
+        dispatchJob(JobType::FINAL, session);
+    }
+}
+
+void WhisperServer::dispatchJob(JobType type, std::shared_ptr<Session> session) {
+    session->inference_running = true;
+    session->job_dispatch_ms = steadyNowMs();
+
+    // A partial (or commit) is only worth running within its step; a final is overdue at once
+    int64_t deadline_ms = session->job_dispatch_ms;
+    if (type != JobType::FINAL) {
+        deadline_ms += effective_step_ms_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        job_queue_.push({type, std::move(session), deadline_ms});
+    }
+    job_cv_.notify_one();
+}
+
+void WhisperServer::workerLoop() {
+    while (true) {
+        InferenceJob job;
+        bool queued_behind = false;  // Other jobs were waiting when this one started
+        {
+            std::unique_lock<std::mutex> lock(job_mutex_);
+            job_cv_.wait(lock, [this] { return !running_ || !job_queue_.empty(); });
+            if (!running_) {
+                return;
             }
-            last_vad_time = now;
-        }
-
-        // === WHISPER INFERENCE (every 500ms) ===
-        auto whisper_elapsed = duration_cast<milliseconds>(now - last_whisper_time).count();
-        if (whisper_elapsed >= whisper_interval_ms) {
-            for (auto& session : sessions) {
-                // If VAD disabled, always run inference (original behavior)
-                if (!vad_ctx_) {
-                    if (!session->inference_running && session->audio->hasMinDuration(config_.step_ms)) {
-                        session->inference_running = true;
-                        runInference(session);
-                        session->inference_running = false;
-                    }
+            job = job_queue_.top();
+            job_queue_.pop();
+            queued_behind = !job_queue_.empty();
+        }
+
+        // Runs on its own spare context, outside the session's one-job-at-a-time flow
+        if (job.type == JobType::SPECULATIVE) {
+            runSpeculativeFinal(job);
+            continue;
+        }
+
+        if (job.session->active) {
+            JobType type = job.type;
+
+            // Speech ended while the job was queued: the final supersedes it
+            if (type != JobType::FINAL && !vad_pool_.empty()) {
+                std::lock_guard<std::mutex> lock(job.session->state_mutex);
+                if (job.session->speech_state == SpeechState::ENDING) {
+                    type = JobType::FINAL;
                 }
-                // If VAD enabled, only run when SPEAKING
-                else if (session->speech_state == SpeechState::SPEAKING) {
-                    if (!session->inference_running) {
-                        session->inference_running = true;
-                        runInference(session);
-                        session->inference_running = false;
-                    }
+            }
+
+            // Under backlog, a partial past its deadline is stale: skip it and let
+            // the next one (which covers the same audio) run a step later. Never
+            // twice in a row, so a session under sustained load still gets partials.
+            auto started = std::chrono::steady_clock::now();
+            int64_t now_ms = steadyNowMs();
+            if (type == JobType::PARTIAL && queued_behind && now_ms > job.deadline_ms &&
+                !job.session->partial_skipped) {
+                job.session->partial_skipped = true;
+                job.session->job_dispatch_ms = now_ms;
+                partials_skipped_++;
+            } else {
+                bool decoded = false;
+                if (type == JobType::FINAL) {
+                    decoded = emitFinal(job.session);
+                } else if (type == JobType::COMMIT) {
+                    decoded = commitSlidAudio(job.session);
+                } else {
+                    job.session->partial_skipped = false;
+                    decoded = runInference(job.session);
                 }
-                // Handle ENDING state - emit final
-                else if (session->speech_state == SpeechState::ENDING) {
-                    emitFinal(session);
+
+                // Jobs that returned early, reused a result or were cancelled would
+                // drag the averages (and the adaptive step) toward zero
+                if (decoded) {
+                    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+                    recordJobTime(type, elapsed.count(), queued_behind);
                 }
             }
-            last_whisper_time = now;
         }
 
-        // Sleep briefly to avoid busy-wait
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // If VAD dropped the utterance (or the session closed) while this job held
+        // the context, return it now
+        std::lock_guard<std::mutex> lock(job.session->state_mutex);
+        if ((job.session->speech_state == SpeechState::IDLE || !job.session->active) &&
+            job.session->context_slot) {
+            releaseContext(job.session->context_slot);
+            job.session->context_slot = nullptr;
+        }
+        job.session->cancel_job = false;
+        job.session->inference_running = false;
+
+        // Schedule the session's next job: partials keep the (load-adaptive) step
+        // cadence from the previous dispatch, a pending final runs right away
+        if (job.session->active) {
+            int64_t now_ms = steadyNowMs();
+            int64_t next_partial_ms = partialSlot(*job.session, job.session->job_dispatch_ms + effective_step_ms_, now_ms);
+            if (vad_pool_.empty()) {
+                if (job.session->audio->hasMinDuration(config_.step_ms)) {
+                    scheduleSession(job.session, next_partial_ms);
+                }
+            } else if (job.session->speech_state == SpeechState::ENDING) {
+                scheduleSession(job.session, now_ms);
+            } else if (job.session->speech_state == SpeechState::SPEAKING) {
+                scheduleSession(job.session, next_partial_ms);
+            }
+        }
     }
 }
 
-void WhisperServer::runInference(std::shared_ptr<Session> session) {
-    if (!session || !session->context_slot || !session->context_slot->ctx) {
+void WhisperServer::recordJobTime(JobType type, double elapsed_ms, bool queued_behind) {
+    static const double kAlpha = 0.2;      // EWMA weight of the newest sample
+    static const double kHeadroom = 1.25;  // Keep workers ~80% busy at most
+    static const double kTighten = 0.9;    // Shrink at most 10% per partial
+
+    std::lock_guard<std::mutex> lock(load_mutex_);
+
+    if (type == JobType::COMMIT) {
+        commits_run_++;
         return;
     }
 
-    whisper_context* ctx = session->context_slot->ctx;
+    if (type == JobType::FINAL) {
+        finals_run_++;
+        final_ms_avg_ = final_ms_avg_ == 0.0 ? elapsed_ms : final_ms_avg_ + kAlpha * (elapsed_ms - final_ms_avg_);
+        return;
+    }
+
+    partials_run_++;
+    partial_ms_avg_ = partial_ms_avg_ == 0.0 ? elapsed_ms : partial_ms_avg_ + kAlpha * (elapsed_ms - partial_ms_avg_);
+
+    if (config_.max_step_ms <= config_.step_ms) {
+        return;  // Fixed cadence
+    }
+
+    // Smallest interval at which every leased context can get a partial per step
+    // on the available workers, with some headroom
+    double workers = std::max<size_t>(1, worker_threads_.size());
+    double target = contexts_in_use_ * partial_ms_avg_ * kHeadroom / workers;
+
+    // Jobs already waiting means we're behind now, whatever the average says
+    double current = effective_step_ms_;
+    if (queued_behind) {
+        target = std::max(target, current * kHeadroom);
+    }
+    target = std::clamp(target, static_cast<double>(config_.step_ms), static_cast<double>(config_.max_step_ms));
+
+    // Back off immediately, recover gradually
+    double next = target >= current ? target : std::max(target, current * kTighten);
+    effective_step_ms_ = static_cast<int>(next);
+}
+
+bool WhisperServer::runInference(std::shared_ptr<Session> session) {
+    if (!session) return false;
+
+    // The slot stays leased while this job runs (the VAD thread defers releases)
+    whisper_state* state = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+        if (session->context_slot) {
+            state = session->context_slot->state;
+        }
+    }
+    if (!state) return false;
 
     const int n_samples_step = (config_.step_ms * WHISPER_SAMPLE_RATE) / 1000;
     const int n_samples_len = (config_.length_ms * WHISPER_SAMPLE_RATE) / 1000;
     const int n_samples_keep = (config_.keep_ms * WHISPER_SAMPLE_RATE) / 1000;
 
-    // Get new audio
-    std::vector<float> pcmf32_new = session->audio->getAll();
-    session->audio->clear();
+    // Take new audio (consumes exactly what was read, so samples pushed meanwhile stay queued).
+    // With streaming VAD, stop at the VAD cursor so VAD sees every sample first.
+    size_t n_available = session->audio->size();
+    if (!vad_pool_.empty() && config_.vad_streaming) {
+        uint64_t start = session->audio->readPosition();
+        uint64_t vad_pos = session->vad_pos.load();
+        n_available = vad_pos > start ? static_cast<size_t>(vad_pos - start) : 0;
+    }
+
+    std::vector<float> pcmf32_new(n_available);
+    pcmf32_new.resize(session->audio->get(pcmf32_new.data(), pcmf32_new.size(), true));
 
     if (pcmf32_new.empty()) {
-        return;
+        return false;
     }
 
     // Build sliding window: [keep from old] + [new audio]
@@ -346,89 +1104,445 @@ void WhisperServer::runInference(std::shared_ptr<Session> session) {
     std::memcpy(pcmf32.data() + n_samples_take, pcmf32_new.data(),
                 pcmf32_new.size() * sizeof(float));
 
-    // Save for next iteration
-    session->pcmf32_old = pcmf32;
+    // Save for next iteration (only workers write pcmf32_old, one job per session)
+    uint64_t window_end = session->audio->readPosition();
+    const bool agreement = config_.local_agreement && !vad_pool_.empty();
+    std::vector<whisper_token> prompt;
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
 
-    // Run whisper inference
-    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+        // Audio leaving the window is kept for a COMMIT job rather than lost
+        size_t n_slid = session->pcmf32_old.size() - n_samples_take;
+        if (config_.commit_ms > 0 && !vad_pool_.empty() && n_slid > 0) {
+            session->commit_audio.insert(session->commit_audio.end(), session->pcmf32_old.begin(),
+                                         session->pcmf32_old.begin() + n_slid);
+        }
 
-    wparams.print_progress = false;
-    wparams.print_special = false;
-    wparams.print_realtime = false;
-    wparams.print_timestamps = false;
-    wparams.translate = config_.translate;
+        // The window now starts later, so the last partial's tokens no longer line up with it
+        if (n_slid > 0) {
+            session->prev_tokens.clear();
+        }
+
+        session->pcmf32_old = pcmf32;
+        session->window_end_pos = window_end;
+        session->partial_current = false;  // Until this window's decode succeeds
+        if (agreement) {
+            prompt = session->committed_tokens;
+        }
+    }
+
+    // Run whisper inference
+    JobCancel cancel{session.get(), JobType::PARTIAL};
+    whisper_full_params wparams = makeDecodeParams(&cancel);
     wparams.single_segment = true;
     wparams.max_tokens = 0;
-    wparams.language = config_.language.c_str();
-    wparams.n_threads = config_.n_threads;
     wparams.no_context = true;
     wparams.no_timestamps = true;
 
-    if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
-        std::cerr << "[whisper-server] Inference failed for session " << session->id << std::endl;
-        return;
+    // Don't run the encoder over 30s of zero padding for a few seconds of audio
+    if (config_.partial_audio_ctx) {
+        wparams.audio_ctx = partialAudioCtx(pcmf32.size(), config_.audio_ctx_margin_ms,
+                                            whisper_n_audio_ctx(model_ctx_));
+    }
+
+    // Committed words were cut from the window: they continue as the prompt instead,
+    // and token times locate where the agreed prefix ends in the audio
+    if (agreement) {
+        wparams.token_timestamps = true;
+        wparams.prompt_tokens = prompt.empty() ? nullptr : prompt.data();
+        wparams.prompt_n_tokens = static_cast<int>(prompt.size());
+    }
+
+    if (whisper_full_with_state(model_ctx_, state, wparams, pcmf32.data(), pcmf32.size()) != 0 ||
+        cancel.cancelled()) {
+        if (cancel.cancelled()) {
+            jobs_cancelled_++;
+            std::cout << "[whisper-server] Partial cancelled for session " << session->id << std::endl;
+        } else {
+            std::cerr << "[whisper-server] Inference failed for session " << session->id << std::endl;
+        }
+        return false;
     }
 
     // Extract text from segments
     std::string text;
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
     for (int i = 0; i < n_segments; ++i) {
-        const char* segment_text = whisper_full_get_segment_text(ctx, i);
+        const char* segment_text = whisper_full_get_segment_text_from_state(state, i);
         if (segment_text) {
             text += segment_text;
         }
     }
 
-    // Trim whitespace
-    size_t start = text.find_first_not_of(" \t\n\r");
-    size_t end = text.find_last_not_of(" \t\n\r");
-    if (start != std::string::npos && end != std::string::npos) {
-        text = text.substr(start, end - start + 1);
-    } else {
-        text.clear();
+    // Text tokens of this decode (special and timestamp tokens sort after EOT)
+    std::vector<whisper_token_data> tokens;
+    if (agreement) {
+        const whisper_token eot = whisper_token_eot(model_ctx_);
+        for (int i = 0; i < n_segments; ++i) {
+            const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+            for (int j = 0; j < n_tokens; ++j) {
+                whisper_token_data data = whisper_full_get_token_data_from_state(state, i, j);
+                if (data.id < eot) {
+                    tokens.push_back(data);
+                }
+            }
+        }
     }
 
-    // Enqueue result if text changed
+    // Trim whitespace
+    text = trimText(text);
+
+    // Enqueue result if text changed (committed text of a long utterance first)
     // Messages are flushed via event-driven callback (notifySessionHasMessages)
-    if (!text.empty() && text != session->last_text) {
-        session->enqueueMessage(makePartialMessage(text));
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+
+        size_t n_agree = 0;
+        if (agreement) {
+            while (n_agree < tokens.size() && n_agree < session->prev_tokens.size() &&
+                   tokens[n_agree].id == session->prev_tokens[n_agree]) {
+                n_agree++;
+            }
+            // Commit whole words only: the next token must begin a new word
+            auto startsWord = [this](whisper_token id) {
+                const char* piece = whisper_token_to_str(model_ctx_, id);
+                return piece && piece[0] == ' ';
+            };
+            while (n_agree > 0 && (n_agree == tokens.size() || !startsWord(tokens[n_agree].id))) {
+                n_agree--;
+            }
+
+            size_t n_cut = 0;
+            if (n_agree > 0) {
+                int64_t cut_t = tokens[n_agree - 1].t1;  // 10 ms units
+                n_cut = std::min(session->pcmf32_old.size(),
+                                 static_cast<size_t>(std::max<int64_t>(0, cut_t)) * WHISPER_SAMPLE_RATE / 100);
+            }
+
+            if (n_cut > 0 && !session->commit_audio.empty()) {
+                // Slid-out audio still waiting for a COMMIT job comes before this
+                // window, so the agreed words can't be committed ahead of it. Their
+                // audio joins the COMMIT instead: the window still shrinks, stops
+                // overflowing, and agreement commits directly once that COMMIT lands.
+                // Until then the words stay on screen as held text.
+                std::string agreed;
+                for (size_t k = 0; k < n_agree; ++k) {
+                    agreed += whisper_token_to_str(model_ctx_, tokens[k].id);
+                }
+                session->held_text = joinText(session->held_text, trimText(agreed));
+                session->commit_audio.insert(session->commit_audio.end(), session->pcmf32_old.begin(),
+                                             session->pcmf32_old.begin() + n_cut);
+                session->pcmf32_old.erase(session->pcmf32_old.begin(), session->pcmf32_old.begin() + n_cut);
+
+                text.clear();
+                for (size_t k = n_agree; k < tokens.size(); ++k) {
+                    text += whisper_token_to_str(model_ctx_, tokens[k].id);
+                }
+                text = trimText(text);
+            } else if (n_cut > 0) {
+                std::string agreed;
+                for (size_t k = 0; k < n_agree; ++k) {
+                    agreed += whisper_token_to_str(model_ctx_, tokens[k].id);
+                    session->committed_tokens.push_back(tokens[k].id);
+                }
+                if (session->committed_tokens.size() > kPromptTokens) {
+                    session->committed_tokens.erase(session->committed_tokens.begin(),
+                                                    session->committed_tokens.end() - kPromptTokens);
+                }
+                session->committed_text = joinText(session->committed_text, trimText(agreed));
+                session->pcmf32_old.erase(session->pcmf32_old.begin(), session->pcmf32_old.begin() + n_cut);
+
+                text.clear();
+                for (size_t k = n_agree; k < tokens.size(); ++k) {
+                    text += whisper_token_to_str(model_ctx_, tokens[k].id);
+                }
+                text = trimText(text);
+            } else {
+                n_agree = 0;
+            }
+        }
+        if (agreement) {
+            session->prev_tokens.clear();
+            for (size_t k = n_agree; k < tokens.size(); ++k) {
+                session->prev_tokens.push_back(tokens[k].id);
+            }
+        }
+
+        std::string display = joinText(joinText(session->committed_text, session->held_text), text);
+        if (!text.empty() && display != session->last_text) {
+            session->enqueueMessage(makePartialMessage(display, session->committed_text));
+            session->last_text = display;
+            changed = true;
+        }
+
+        // Save for potential final: this is what pcmf32_old decodes to
+        session->pending_text = text;
+        session->partial_current = true;
+        session->partial_end_pos = window_end;
+    }
+    if (changed) {
         notifySessionHasMessages(session->id);
-        session->pending_text = text;  // Save for potential final
-        session->last_text = text;
     }
+    return true;
+}
+
+bool WhisperServer::commitSlidAudio(std::shared_ptr<Session> session) {
+    // Segments ending this close to the cut may be missing their last word
+    static const int kCommitGuardMs = 1000;
+
+    std::vector<float> pcmf32;
+    whisper_state* state = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+        if (session->context_slot) {
+            state = session->context_slot->state;
+        }
+        pcmf32 = session->commit_audio;
+    }
+    if (!state || pcmf32.empty()) return false;
+
+    JobCancel cancel{session.get(), JobType::COMMIT};
+    whisper_full_params wparams = makeDecodeParams(&cancel);
+    wparams.single_segment = false;  // Segment timestamps decide what is safe to commit
+    wparams.no_context = true;
+
+    if (whisper_full_with_state(model_ctx_, state, wparams, pcmf32.data(), pcmf32.size()) != 0 ||
+        cancel.cancelled()) {
+        if (cancel.cancelled()) {
+            jobs_cancelled_++;
+        } else {
+            std::cerr << "[whisper-server] Commit inference failed for session " << session->id << std::endl;
+        }
+        return false;
+    }
+
+    // Commit whole segments that end clear of the cut; the rest of the audio is
+    // carried over and decoded again next time (or by the final) with what follows
+    int64_t audio_ms = static_cast<int64_t>(pcmf32.size()) * 1000 / WHISPER_SAMPLE_RATE;
+    std::string text;
+    int64_t commit_end_ms = 0;
+    int n_committed_segments = 0;
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        int64_t t1_ms = whisper_full_get_segment_t1_from_state(state, i) * 10;
+        if (t1_ms > audio_ms - kCommitGuardMs) {
+            break;
+        }
+        const char* segment_text = whisper_full_get_segment_text_from_state(state, i);
+        if (segment_text) {
+            text += segment_text;
+        }
+        commit_end_ms = t1_ms;
+        n_committed_segments = i + 1;
+    }
+
+    // One long segment never ends clear of the cut: commit it all rather than
+    // let the backlog grow without bound
+    size_t commit_samples = static_cast<size_t>(config_.commit_ms) * WHISPER_SAMPLE_RATE / 1000;
+    if (commit_end_ms == 0 && pcmf32.size() >= 2 * commit_samples) {
+        text.clear();
+        for (int i = 0; i < n_segments; ++i) {
+            const char* segment_text = whisper_full_get_segment_text_from_state(state, i);
+            if (segment_text) {
+                text += segment_text;
+            }
+        }
+        commit_end_ms = audio_ms;
+        n_committed_segments = n_segments;
+    }
+    if (commit_end_ms == 0) return true;
+
+    // The committed words become the prompt of later decodes, so the decoder
+    // continues from them rather than from older agreed text
+    std::vector<whisper_token> tokens;
+    const whisper_token eot = whisper_token_eot(model_ctx_);
+    for (int i = 0; i < n_committed_segments; ++i) {
+        const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
+            if (id < eot) {
+                tokens.push_back(id);
+            }
+        }
+    }
+
+    size_t n_committed = std::min(pcmf32.size(),
+                                  static_cast<size_t>(commit_end_ms * WHISPER_SAMPLE_RATE / 1000));
+
+    std::lock_guard<std::mutex> lock(session->state_mutex);
+    session->committed_text = joinText(session->committed_text, trimText(text));
+    session->committed_tokens.insert(session->committed_tokens.end(), tokens.begin(), tokens.end());
+    if (session->committed_tokens.size() > kPromptTokens) {
+        session->committed_tokens.erase(session->committed_tokens.begin(),
+                                        session->committed_tokens.end() - kPromptTokens);
+    }
+    session->commit_audio.erase(session->commit_audio.begin(), session->commit_audio.begin() + n_committed);
+    size_t n_carried = session->commit_audio.size();
+
+    // The uncommitted rest goes back in front of the window. Left in commit_audio it
+    // would never drain (the guard always holds some back), and local agreement and
+    // final reuse only run while nothing is pending ahead of the window.
+    session->pcmf32_old.insert(session->pcmf32_old.begin(), session->commit_audio.begin(),
+                               session->commit_audio.end());
+    session->commit_audio.clear();
+    session->held_text.clear();            // Now in committed_text or back in the window
+    session->prev_tokens.clear();          // The window starts earlier now
+    session->partial_current = false;      // pending_text no longer covers pcmf32_old
+
+    std::cout << "[VAD:" << session->id << "] Committed " << commit_end_ms << "ms of slid-out audio ("
+              << (n_carried * 1000 / WHISPER_SAMPLE_RATE) << "ms carried)" << std::endl;
+    return true;
 }
 
 // === VAD Methods ===
 
-float WhisperServer::detectSpeechProb(const float* samples, int n_samples) {
-    if (!vad_ctx_ || n_samples == 0) return 0.0f;
+whisper_vad_context* WhisperServer::acquireVadContext() {
+    std::unique_lock<std::mutex> lock(vad_pool_mutex_);
+    vad_pool_cv_.wait(lock, [this] { return !vad_free_.empty(); });
 
-    std::lock_guard<std::mutex> lock(vad_mutex_);
+    whisper_vad_context* vad_ctx = vad_free_.back();
+    vad_free_.pop_back();
+    return vad_ctx;
+}
+
+void WhisperServer::releaseVadContext(whisper_vad_context* vad_ctx) {
+    {
+        std::lock_guard<std::mutex> lock(vad_pool_mutex_);
+        vad_free_.push_back(vad_ctx);
+    }
+    vad_pool_cv_.notify_one();
+}
+
+void WhisperServer::vadLoop(int shard) {
+    using namespace std::chrono;
+
+    const auto vad_interval = milliseconds(config_.vad_check_ms);  // 30ms
+    auto next_check = steady_clock::now();
+    VadPass pass;
+
+    while (running_) {
+        next_check += vad_interval;
+        int64_t now_ms = steadyNowMs();
+
+        // Snapshot of this thread's sessions
+        pass.clear();
+        {
+            std::unique_lock<std::mutex> lock(sessions_mutex_);
+            auto collect = [&] {
+                for (auto& [id, session] : sessions_) {
+                    if (session->active && session->vad_shard == shard) {
+                        pass.sessions.push_back(session);
+                    }
+                }
+                return !pass.sessions.empty();
+            };
+
+            // Nothing to watch: sleep until a session is created instead of polling.
+            // running_ is re-checked under the lock so a stop() that lands between
+            // the loop condition and the wait can't be missed.
+            if (!collect()) {
+                sessions_cv_.wait(lock, [&] { return !running_ || collect(); });
+                if (!running_) break;
+                next_check = steady_clock::now() + vad_interval;
+                now_ms = steadyNowMs();
+            }
+        }
 
-    // Disable whisper internal logging during VAD (too verbose)
-    whisper_log_set(whisper_log_disable, nullptr);
+        // Evaluate every session's new audio, then fan the probabilities back out.
+        // Runs regardless of inference in flight, so onsets and endings are
+        // detected on time even while a worker is decoding.
+        runVadPass(pass);
 
-    bool success = whisper_vad_detect_speech(vad_ctx_, samples, n_samples);
+        for (size_t i = 0; i < pass.sessions.size(); ++i) {
+            updateVADState(pass.sessions[i], pass.counts[i] > 0, pass.probs[i], now_ms);
+        }
 
-    // Re-enable logging
-    whisper_log_set(nullptr, nullptr);
+        // Fixed cadence; if a pass overran, start the next one immediately
+        auto now = steady_clock::now();
+        if (next_check < now) {
+            next_check = now;
+        }
+        std::this_thread::sleep_until(next_check);
+    }
+}
 
-    if (!success) return 0.0f;
+size_t WhisperServer::gatherVadInput(Session& session, std::vector<float>& out) {
+    AudioBuffer& audio = *session.audio;
 
-    int n_probs = whisper_vad_n_probs(vad_ctx_);
-    if (n_probs == 0) return 0.0f;
+    if (!config_.vad_streaming) {
+        // Get last 30ms of audio for VAD
+        out = audio.getLastMs(config_.vad_check_ms);
+        return out.size();
+    }
 
-    const float* probs = whisper_vad_probs(vad_ctx_);
-    return probs[n_probs - 1];
+    // Analyze each new sample exactly once, in whole windows: a partial window
+    // is analyzed on a later check, once complete
+    uint64_t end = audio.writePosition();
+    uint64_t pos = session.vad_pos.load();
+    size_t n_new = end > pos ? static_cast<size_t>(end - pos) : 0;
+    n_new -= n_new % kVadWindowSamples;
+    out.resize(n_new);
+    if (n_new == 0) return 0;
+
+    size_t n_read = audio.getFrom(pos, out.data(), n_new);
+    n_read -= n_read % kVadWindowSamples;
+    out.resize(n_read);
+    session.vad_pos = pos + n_read;
+
+    return n_read;
 }
 
-void WhisperServer::updateVADState(std::shared_ptr<Session> session, int64_t now_ms) {
-    // Get last 30ms of audio for VAD
-    std::vector<float> recent_audio = session->audio->getLastMs(config_.vad_check_ms);
+void WhisperServer::runVadPass(VadPass& pass) {
+    pass.counts.assign(pass.sessions.size(), 0);
+    pass.probs.assign(pass.sessions.size(), 0.0f);
+
+    // One context lease and one log mute for the whole pass, taken on the first
+    // session with new audio. whisper.cpp's VAD has no batch dimension, so each
+    // session is still its own whisper_vad_detect_speech() call.
+    whisper_vad_context* vad_ctx = nullptr;
+
+    for (size_t i = 0; i < pass.sessions.size(); ++i) {
+        pass.counts[i] = gatherVadInput(*pass.sessions[i], pass.samples);
+        if (pass.counts[i] == 0) continue;
+
+        if (!vad_ctx) {
+            vad_ctx = acquireVadContext();
+            t_whisper_log_quiet = true;
+        }
+
+        // whisper_vad_detect_speech() resets the LSTM state per call, which keeps
+        // sessions independent, and carries it across the windows within the
+        // call, so a session's new windows go in together
+        if (!whisper_vad_detect_speech(vad_ctx, pass.samples.data(), static_cast<int>(pass.counts[i]))) {
+            continue;
+        }
+
+        int n_probs = whisper_vad_n_probs(vad_ctx);
+        if (n_probs == 0) continue;
+
+        // Streaming: any speech among the new windows counts. Otherwise the
+        // latest window decides.
+        const float* probs = whisper_vad_probs(vad_ctx);
+        pass.probs[i] = config_.vad_streaming ? *std::max_element(probs, probs + n_probs)
+                                              : probs[n_probs - 1];
+    }
+
+    if (vad_ctx) {
+        t_whisper_log_quiet = false;
+        releaseVadContext(vad_ctx);
+    }
+}
+
+void WhisperServer::updateVADState(std::shared_ptr<Session> session, bool have_audio,
+                                   float speech_prob, int64_t now_ms) {
+    // Inference runs unlocked on a worker; the lock only orders state changes
+    std::lock_guard<std::mutex> lock(session->state_mutex);
+    if (!session->active) return;  // Being destroyed - don't lease a context
 
     // For WAITING_FOR_CONTEXT, we need to keep trying even without new audio
     // (user may have stopped recording while waiting)
-    if (recent_audio.empty()) {
+    if (!have_audio) {
         if (session->speech_state == SpeechState::WAITING_FOR_CONTEXT) {
             // Treat as silence - this will trigger catch-up inference attempt
             // when enough silence time has passed
@@ -437,15 +1551,28 @@ void WhisperServer::updateVADState(std::shared_ptr<Session> session, int64_t now
         }
     }
 
-    float speech_prob = recent_audio.empty() ? 0.0f :
-        detectSpeechProb(recent_audio.data(), recent_audio.size());
     bool is_speech = speech_prob > config_.vad_threshold;
+    if (is_speech) {
+        session->last_speech_pos = config_.vad_streaming ? session->vad_pos.load()
+                                                         : session->audio->writePosition();
+    }
+
+    // While a job is in flight the worker is the audio consumer, and the slot it
+    // is decoding with stays leased until it finishes (see workerLoop)
+    bool job_in_flight = session->inference_running;
+    SpeechState prev_state = session->speech_state;
 
     switch (session->speech_state) {
         case SpeechState::IDLE:
-            if (is_speech) {
-                // Try to lease a context for this utterance
-                ContextSlot* slot = acquireContext();
+            if (!is_speech) {
+                // Only the pre-roll before a possible onset is worth keeping
+                if (!job_in_flight) {
+                    session->audio->keepLastMs(config_.vad_preroll_ms);
+                }
+            } else {
+                // Try to lease a context for this utterance (or keep the one a
+                // finishing job still holds)
+                ContextSlot* slot = session->context_slot ? session->context_slot : acquireContext(*session);
                 if (slot) {
                     session->context_slot = slot;
                     session->speech_state = SpeechState::SPEAKING;
@@ -455,7 +1582,7 @@ void WhisperServer::updateVADState(std::shared_ptr<Session> session, int64_t now
                     std::cout << "[VAD:" << session->id << "] Leased context " << slot->slot_id << std::endl;
                     std::cout << "[VAD:" << session->id << "] === SPEECH STARTED ===" << std::endl;
                 } else {
-                    // No context available - enter waiting state
+                    // No context available - wait in the admission queue
                     session->speech_state = SpeechState::WAITING_FOR_CONTEXT;
                     session->speech_start_ms = now_ms;
                     session->last_speech_ms = now_ms;
@@ -466,63 +1593,77 @@ void WhisperServer::updateVADState(std::shared_ptr<Session> session, int64_t now
             }
             break;
 
-        case SpeechState::WAITING_FOR_CONTEXT:
+        case SpeechState::WAITING_FOR_CONTEXT: {
             if (is_speech) {
                 session->last_speech_ms = now_ms;
-                // Keep trying to acquire context
-                ContextSlot* slot = acquireContext();
-                if (slot) {
-                    session->context_slot = slot;
-                    session->speech_state = SpeechState::SPEAKING;
-                    std::cout << "[VAD:" << session->id << "] Leased context " << slot->slot_id
-                              << " (was waiting " << (now_ms - session->waiting_start_ms) << "ms)" << std::endl;
-                    std::cout << "[VAD:" << session->id << "] === SPEECH STARTED (delayed) ===" << std::endl;
-                }
+            }
+
+            int silence_ms = now_ms - session->last_speech_ms;
+            if (silence_ms >= config_.silence_trigger_ms &&
+                now_ms - session->speech_start_ms < config_.min_speech_ms) {
+                // Too short, discard (no job runs without a context) and give up our place
+                leaveAdmissionQueue(*session);
+                session->speech_state = SpeechState::IDLE;
+                session->audio->clear();
+                std::cout << "[VAD:" << session->id << "] Discarded short utterance while waiting" << std::endl;
+                break;
+            }
+
+            // A released context is handed to the longest waiter; pick it up if it's ours
+            ContextSlot* slot = acquireContext(*session);
+            if (!slot) {
+                break;  // Still queued
+            }
+            session->context_slot = slot;
+            if (silence_ms >= config_.silence_trigger_ms) {
+                // User stopped speaking while waiting: catch-up inference on buffered audio
+                session->speech_state = SpeechState::ENDING;
+                std::cout << "[VAD:" << session->id << "] Leased context " << slot->slot_id
+                          << " for catch-up inference" << std::endl;
+                std::cout << "[VAD:" << session->id << "] === SPEECH ENDED (was waiting) ===" << std::endl;
             } else {
-                // User stopped speaking while waiting for context
-                int silence_ms = now_ms - session->last_speech_ms;
-                if (silence_ms >= config_.silence_trigger_ms) {
-                    int speech_duration = now_ms - session->speech_start_ms;
-                    if (speech_duration >= config_.min_speech_ms) {
-                        // Need to do catch-up inference on buffered audio
-                        ContextSlot* slot = acquireContext();
-                        if (slot) {
-                            session->context_slot = slot;
-                            session->speech_state = SpeechState::ENDING;
-                            std::cout << "[VAD:" << session->id << "] Leased context " << slot->slot_id
-                                      << " for catch-up inference" << std::endl;
-                            std::cout << "[VAD:" << session->id << "] === SPEECH ENDED (was waiting) ===" << std::endl;
-                        }
-                        // If still no context, stay in WAITING_FOR_CONTEXT - we'll retry
-                    } else {
-                        // Too short, discard
-                        session->speech_state = SpeechState::IDLE;
-                        session->audio->clear();
-                        std::cout << "[VAD:" << session->id << "] Discarded short utterance while waiting" << std::endl;
-                    }
-                }
+                session->speech_state = SpeechState::SPEAKING;
+                std::cout << "[VAD:" << session->id << "] Leased context " << slot->slot_id
+                          << " (was waiting " << (now_ms - session->waiting_start_ms) << "ms)" << std::endl;
+                std::cout << "[VAD:" << session->id << "] === SPEECH STARTED (delayed) ===" << std::endl;
             }
             break;
+        }
 
         case SpeechState::SPEAKING:
             if (is_speech) {
                 session->last_speech_ms = now_ms;
+                if (session->spec_started) {
+                    discardSpeculativeFinal(*session);  // The pause was not the end
+                }
             } else {
                 int silence_ms = now_ms - session->last_speech_ms;
+                if (config_.speculative_final_ms > 0 && silence_ms >= config_.speculative_final_ms &&
+                    silence_ms < config_.silence_trigger_ms && !session->spec_started &&
+                    now_ms - session->speech_start_ms >= config_.min_speech_ms) {
+                    dispatchSpeculativeFinal(session);
+                }
                 if (silence_ms >= config_.silence_trigger_ms) {
                     int speech_duration = now_ms - session->speech_start_ms;
                     float audio_duration_ms = (session->pcmf32_old.size() * 1000.0f) / WHISPER_SAMPLE_RATE;
 
                     if (speech_duration >= config_.min_speech_ms) {
                         session->speech_state = SpeechState::ENDING;
+                        // The final supersedes a partial or commit in flight, unless that
+                        // partial is what the final will reuse
+                        bool reusable = reuse_partial_final_ && session->commit_audio.empty() &&
+                                        !session->spec_ready;
+                        session->cancel_job = job_in_flight && !reusable;
                         std::cout << "[VAD:" << session->id << "] === SPEECH ENDED ===" << std::endl;
                         std::cout << "[VAD:" << session->id << "]   Speech duration: " << speech_duration << "ms" << std::endl;
                         std::cout << "[VAD:" << session->id << "]   Audio buffer: " << audio_duration_ms << "ms" << std::endl;
                         std::cout << "[VAD:" << session->id << "]   Last partial: \"" << session->pending_text << "\"" << std::endl;
                     } else {
-                        // Too short, ignore and release context
+                        // Too short, ignore and release context (a job in flight
+                        // is aborted and returns it)
                         session->speech_state = SpeechState::IDLE;
-                        if (session->context_slot) {
+                        session->cancel_job = job_in_flight;
+                        if (session->context_slot && !job_in_flight) {
                             std::cout << "[VAD:" << session->id << "] Released context " << session->context_slot->slot_id
                                       << " (utterance too short)" << std::endl;
                             releaseContext(session->context_slot);
@@ -539,58 +1680,105 @@ void WhisperServer::updateVADState(std::shared_ptr<Session> session, int64_t now
             if (is_speech) {
                 session->speech_state = SpeechState::SPEAKING;
                 session->last_speech_ms = now_ms;
+                session->cancel_job = false;  // Partials are wanted again
+                discardSpeculativeFinal(*session);
                 std::cout << "[VAD:" << session->id << "] Speech resumed (user interrupted)" << std::endl;
             }
             break;
     }
-}
 
-void WhisperServer::emitFinal(std::shared_ptr<Session> session) {
-    if (session->speech_state != SpeechState::ENDING) return;
+    // Publish transitions to the scheduler. A fresh onset waits for a step of
+    // audio; anything else (delayed start, resume, final) is due now.
+    if (session->speech_state != prev_state) {
+        if (session->speech_state == SpeechState::ENDING) {
+            scheduleSession(session, now_ms);
+        } else if (session->speech_state == SpeechState::SPEAKING) {
+            scheduleSession(session, prev_state == SpeechState::IDLE
+                ? partialSlot(*session, now_ms + config_.step_ms, now_ms) : now_ms);
+        }
+    }
+}
 
+bool WhisperServer::emitFinal(std::shared_ptr<Session> session) {
     std::string final_text;
+    std::string committed_text;
+    std::vector<whisper_token> prompt;
+    std::vector<float> pcmf32;
+    whisper_state* state = nullptr;
 
-    // Use accumulated audio from pcmf32_old (runInference clears audio buffer)
-    // For catch-up inference (WAITING_FOR_CONTEXT → ENDING), pcmf32_old may be empty
-    // and audio is still in the buffer
-    std::vector<float> pcmf32 = session->pcmf32_old;
-    if (pcmf32.empty()) {
-        // Catch-up case: audio never went through inference, still in buffer
-        pcmf32 = session->audio->getAll();
+    // Audio up to this stream position belongs to the utterance being finalized
+    uint64_t final_end = 0;
+    bool reuse_partial = false;
+    bool use_speculative = false;
+    bool decoded = false;
+
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+        if (session->speech_state != SpeechState::ENDING) return false;
+
+        // A speculative final decoded the whole utterance during the pause, and
+        // no speech came after the audio it covered
+        if (session->spec_ready && session->last_speech_pos <= session->spec_end_pos) {
+            use_speculative = true;
+            final_text = session->spec_text;
+        }
+        // The last partial already decoded this exact window, and VAD heard no
+        // speech after it: decoding again would only repeat that work
+        else if (reuse_partial_final_ && session->partial_current && !session->pcmf32_old.empty() &&
+                 session->commit_audio.empty() && session->last_speech_pos <= session->partial_end_pos) {
+            reuse_partial = true;
+            final_text = session->pending_text;
+        }
+
+        // Use accumulated audio from pcmf32_old (runInference clears audio buffer)
+        // For catch-up inference (WAITING_FOR_CONTEXT → ENDING), pcmf32_old may be empty
+        // and audio is still in the buffer
+        // Long utterance: text already committed is kept, and the not-yet-committed
+        // slid-out audio is decoded together with the window (contiguous, so no
+        // word is cut at the seam)
+        committed_text = session->committed_text;
+        prompt = session->committed_tokens;
+        pcmf32 = session->commit_audio;
+        pcmf32.insert(pcmf32.end(), session->pcmf32_old.begin(), session->pcmf32_old.end());
+        final_end = session->audio->readPosition();
+        if (pcmf32.empty()) {
+            // Catch-up case: audio never went through inference, still in buffer
+            final_end = session->audio->writePosition();
+            pcmf32 = session->audio->getAll();
+        }
+        if (session->context_slot) {
+            state = session->context_slot->state;
+        }
+        if (use_speculative) {
+            committed_text.clear();  // Already part of spec_text
+            final_end = std::max(final_end, session->spec_end_pos);
+        } else {
+            // This final doesn't need the speculative decode: cancel one still
+            // running now so it frees its context instead of racing this decode
+            discardSpeculativeFinal(*session);
+        }
+        decoded = !use_speculative && !reuse_partial && !pcmf32.empty() && state;
     }
     float duration_ms = (pcmf32.size() * 1000.0f) / WHISPER_SAMPLE_RATE;
 
-    std::cout << "[VAD:" << session->id << "] Running final inference..." << std::endl;
-    std::cout << "[VAD:" << session->id << "]   Audio samples: " << pcmf32.size()
-              << " (" << duration_ms << "ms)" << std::endl;
-
-    if (!pcmf32.empty() && session->context_slot && session->context_slot->ctx) {
-        whisper_context* ctx = session->context_slot->ctx;
-        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        wparams.print_progress = false;
-        wparams.print_special = false;
-        wparams.print_realtime = false;
-        wparams.print_timestamps = false;
-        wparams.translate = config_.translate;
-        wparams.single_segment = false;
-        wparams.language = config_.language.c_str();
-        wparams.n_threads = config_.n_threads;
-
-        if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) == 0) {
-            for (int i = 0; i < whisper_full_n_segments(ctx); ++i) {
-                const char* seg = whisper_full_get_segment_text(ctx, i);
-                if (seg) final_text += seg;
-            }
-            // Trim
-            size_t start = final_text.find_first_not_of(" \t\n\r");
-            size_t end = final_text.find_last_not_of(" \t\n\r");
-            if (start != std::string::npos && end != std::string::npos) {
-                final_text = final_text.substr(start, end - start + 1);
-            } else {
-                final_text.clear();
-            }
-        }
+    if (use_speculative) {
+        std::cout << "[VAD:" << session->id << "] Final uses speculative decode (no speech since)" << std::endl;
+        speculative_used_++;
+    } else if (reuse_partial) {
+        std::cout << "[VAD:" << session->id << "] Final reuses last partial (no speech since, "
+                  << duration_ms << "ms window)" << std::endl;
+        finals_reused_++;
+    } else {
+        std::cout << "[VAD:" << session->id << "] Running final inference..." << std::endl;
+        std::cout << "[VAD:" << session->id << "]   Audio samples: " << pcmf32.size()
+                  << " (" << duration_ms << "ms)" << std::endl;
+    }
+
+    if (decoded) {
+        JobCancel cancel{session.get(), JobType::FINAL};
+        final_text = decodeFinalText(state, pcmf32, prompt, cancel);
     }
+    final_text = joinText(committed_text, final_text);
 
     if (!final_text.empty()) {
         session->enqueueMessage(makeFinalMessage(final_text));
@@ -602,10 +1790,32 @@ void WhisperServer::emitFinal(std::shared_ptr<Session> session) {
     }
 
     // Reset state
-    session->speech_state = SpeechState::IDLE;
+    std::lock_guard<std::mutex> lock(session->state_mutex);
     session->pending_text.clear();
+    session->partial_current = false;
     session->pcmf32_old.clear();
     session->last_text.clear();
+    session->committed_text.clear();
+    session->commit_audio.clear();
+    session->held_text.clear();
+    session->prev_tokens.clear();
+    session->committed_tokens.clear();
+    discardSpeculativeFinal(*session);
+
+    if (session->speech_state == SpeechState::SPEAKING) {
+        // Speech resumed while the final was decoding: drop only the finalized
+        // audio and carry on with the new utterance on the same context
+        uint64_t read_pos = session->audio->readPosition();
+        if (final_end > read_pos) {
+            session->audio->consume(static_cast<size_t>(final_end - read_pos));
+        }
+        session->speech_start_ms = session->last_speech_ms;
+        std::cout << "[VAD:" << session->id << "] Speech resumed during final, keeping context "
+                  << (session->context_slot ? session->context_slot->slot_id : -1) << std::endl;
+        return decoded;
+    }
+
+    session->speech_state = SpeechState::IDLE;
     session->audio->clear();
 
     // Release context back to pool for other sessions
@@ -614,6 +1824,145 @@ void WhisperServer::emitFinal(std::shared_ptr<Session> session) {
         releaseContext(session->context_slot);
         session->context_slot = nullptr;
     }
+    return decoded;
+}
+
+bool JobCancel::cancelled() const {
+    if (!session->active) {
+        return true;  // Nobody left to send the result to
+    }
+    switch (type) {
+        case JobType::PARTIAL:
+        case JobType::COMMIT:
+            return session->cancel_job;
+        case JobType::SPECULATIVE:
+            return session->spec_generation != generation;
+        case JobType::FINAL:
+            break;
+    }
+    return false;
+}
+
+whisper_full_params WhisperServer::makeDecodeParams(JobCancel* cancel) const {
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.print_progress = false;
+    wparams.print_special = false;
+    wparams.print_realtime = false;
+    wparams.print_timestamps = false;
+    wparams.translate = config_.translate;
+    wparams.language = config_.language.c_str();
+    wparams.n_threads = config_.n_threads;
+
+    // Let whisper_full() stop early once the job is no longer wanted
+    if (cancel) {
+        wparams.abort_callback = jobAbortCallback;
+        wparams.abort_callback_user_data = cancel;
+    }
+    return wparams;
+}
+
+std::string WhisperServer::decodeFinalText(whisper_state* state, const std::vector<float>& pcmf32,
+                                           const std::vector<whisper_token>& prompt, JobCancel& cancel) {
+    whisper_full_params wparams = makeDecodeParams(&cancel);
+    wparams.single_segment = false;
+    if (!prompt.empty()) {
+        // Words committed by local agreement lead into this audio
+        wparams.prompt_tokens = prompt.data();
+        wparams.prompt_n_tokens = static_cast<int>(prompt.size());
+    }
+
+    std::string text;
+    if (whisper_full_with_state(model_ctx_, state, wparams, pcmf32.data(), pcmf32.size()) != 0 ||
+        cancel.cancelled()) {
+        if (cancel.cancelled()) {
+            jobs_cancelled_++;
+        }
+        return text;
+    }
+    for (int i = 0; i < whisper_full_n_segments_from_state(state); ++i) {
+        const char* seg = whisper_full_get_segment_text_from_state(state, i);
+        if (seg) text += seg;
+    }
+    return trimText(text);
+}
+
+void WhisperServer::dispatchSpeculativeFinal(const std::shared_ptr<Session>& session) {
+    // Caller holds session->state_mutex. Only an idle context is borrowed, never
+    // one a queued session is waiting for; without one the final is decoded as usual.
+    session->spec_started = true;
+    ContextSlot* slot = acquireContext(*session, false);
+    if (!slot) return;
+
+    std::cout << "[VAD:" << session->id << "] Speculative final on context " << slot->slot_id << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        job_queue_.push({JobType::SPECULATIVE, session, steadyNowMs(), slot, session->spec_generation});
+    }
+    job_cv_.notify_one();
+}
+
+void WhisperServer::discardSpeculativeFinal(Session& session) {
+    // Caller holds session.state_mutex; a job still running sees the new generation
+    session.spec_started = false;
+    session.spec_ready = false;
+    session.spec_text.clear();
+    session.spec_generation++;
+}
+
+void WhisperServer::runSpeculativeFinal(const InferenceJob& job) {
+    const auto& session = job.session;
+    std::string committed_text;
+    std::vector<whisper_token> prompt;
+    std::vector<float> pcmf32;
+    uint64_t end_pos = 0;
+    bool current = false;
+
+    // Snapshot the whole utterance so far: [commit_audio][pcmf32_old][audio not yet
+    // taken by a partial, up to what VAD has checked]
+    {
+        std::lock_guard<std::mutex> lock(session->state_mutex);
+        current = session->active && session->spec_generation == job.generation &&
+                  session->speech_state == SpeechState::SPEAKING;
+        if (current) {
+            committed_text = session->committed_text;
+            prompt = session->committed_tokens;
+            pcmf32 = session->commit_audio;
+            pcmf32.insert(pcmf32.end(), session->pcmf32_old.begin(), session->pcmf32_old.end());
+
+            uint64_t pos = session->pcmf32_old.empty() ? session->audio->readPosition()
+                                                       : session->window_end_pos;
+            end_pos = config_.vad_streaming ? session->vad_pos.load() : session->audio->writePosition();
+            size_t n_new = end_pos > pos ? static_cast<size_t>(end_pos - pos) : 0;
+
+            // A partial taking audio right now leaves a gap at pos: give up, the
+            // regular final still runs
+            uint64_t from = pos;
+            size_t offset = pcmf32.size();
+            pcmf32.resize(offset + n_new);
+            size_t n_read = session->audio->getFrom(from, pcmf32.data() + offset, n_new);
+            current = from == pos && n_read == n_new;
+        }
+    }
+
+    std::string text;
+    if (current && !pcmf32.empty()) {
+        speculative_run_++;
+        JobCancel cancel{session.get(), JobType::SPECULATIVE, job.generation};
+        text = decodeFinalText(job.slot->state, pcmf32, prompt, cancel);
+        if (!text.empty()) {
+            text = joinText(committed_text, text);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(session->state_mutex);
+    if (current && !text.empty() && session->spec_generation == job.generation) {
+        session->spec_text = text;
+        session->spec_end_pos = end_pos;
+        session->spec_ready = true;
+        std::cout << "[VAD:" << session->id << "] Speculative final ready ("
+                  << (pcmf32.size() * 1000 / WHISPER_SAMPLE_RATE) << "ms)" << std::endl;
+    }
+    releaseContext(job.slot);
 }
 
 // === Event Loop Integration ===
@@ -700,10 +2049,11 @@ std::string WhisperServer::makeReadyMessage() {
     return msg.dump();
 }
 
-std::string WhisperServer::makePartialMessage(const std::string& text) {
+std::string WhisperServer::makePartialMessage(const std::string& text, const std::string& stable) {
     json msg;
     msg["type"] = "partial";
     msg["text"] = text;
+    msg["stable"] = stable;  // Prefix of text that later partials will not change
     return msg.dump();
 }
 
@@ -720,3 +2070,74 @@ std::string WhisperServer::makeErrorMessage(const std::string& error) {
     msg["message"] = error;
     return msg.dump();
 }
+
+std::string WhisperServer::makeMetricsJson() {
+    json msg;
+
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        msg["sessions"] = sessions_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        msg["job_queue_depth"] = job_queue_.size();
+    }
+    msg["contexts"] = contexts_live_.load();
+    msg["contexts_in_use"] = contexts_in_use_.load();
+    msg["contexts_min"] = min_live_;
+    msg["contexts_max"] = max_live_;
+    msg["contexts_created"] = contexts_created_.load();
+    msg["contexts_freed"] = contexts_freed_.load();
+    msg["context_mb"] = context_bytes_ >> 20;
+    msg["startup_ms"] = startup_ms_;
+    msg["model_load_ms"] = model_load_ms_;
+    msg["contexts_ready_ms"] = contexts_ready_ms_;
+    msg["workers"] = worker_threads_.size();
+
+    msg["step_ms"] = config_.step_ms;
+    msg["effective_step_ms"] = effective_step_ms_.load();
+    msg["max_step_ms"] = config_.max_step_ms;
+
+    msg["partials_run"] = partials_run_.load();
+    msg["partials_skipped"] = partials_skipped_.load();
+    msg["finals_run"] = finals_run_.load();
+    msg["finals_reused"] = finals_reused_.load();
+    msg["commits_run"] = commits_run_.load();
+    msg["speculative_finals_run"] = speculative_run_.load();
+    msg["speculative_finals_used"] = speculative_used_.load();
+    msg["jobs_cancelled"] = jobs_cancelled_.load();
+    json slots = json::array();
+    int64_t now_ms = steadyNowMs();
+    for (const auto& slot : context_pool_) {
+        int64_t leased_at = slot->leased_at_ms.load(std::memory_order_relaxed);
+        uint64_t leases = slot->lease_count.load(std::memory_order_relaxed);
+        uint64_t total_ms = slot->lease_ms_total.load(std::memory_order_relaxed);
+        json entry;
+        entry["id"] = slot->slot_id;
+        entry["live"] = slot->live.load(std::memory_order_relaxed);
+        entry["in_use"] = leased_at != 0;
+        entry["current_lease_ms"] = leased_at != 0 ? now_ms - leased_at : 0;
+        entry["leases"] = leases;
+        entry["lease_ms_total"] = total_ms;
+        entry["lease_ms_max"] = slot->lease_ms_max.load(std::memory_order_relaxed);
+        slots.push_back(entry);
+    }
+    msg["context_slots"] = slots;
+
+    {
+        std::lock_guard<std::mutex> lock(admission_mutex_);
+        msg["admission_queue_depth"] = admission_queue_.size();
+        msg["admission_wait_ms_current"] = admission_queue_.oldestWaitMs(steadyNowMs());
+        msg["admission_wait_ms_avg"] = admissions_ == 0 ? 0.0
+            : static_cast<double>(admission_wait_ms_total_) / admissions_;
+        msg["admission_wait_ms_max"] = admission_wait_ms_worst_;
+        msg["admissions_queued"] = admissions_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        msg["partial_ms_avg"] = partial_ms_avg_;
+        msg["final_ms_avg"] = final_ms_avg_;
+    }
+
+    return msg.dump();
+}
@@ -1,12 +1,14 @@
 #ifndef WHISPER_SERVER_HPP
 #define WHISPER_SERVER_HPP
 
+#include "admission_queue.hpp"
 #include "audio_buffer.hpp"
 #include "whisper.h"
 
 #include <string>
 #include <vector>
 #include <deque>
+#include <queue>
 #include <memory>
 #include <atomic>
 #include <thread>
@@ -21,38 +23,72 @@ struct ServerConfig {
     std::string language = "en";
     std::string host = "0.0.0.0";       // Bind address (all interfaces by default)
     int port = 9090;
-    int n_contexts = 2;       // Number of parallel whisper contexts
+    int n_contexts = 2;       // Number of parallel whisper contexts (ceiling when elastic)
+    int min_contexts = 0;     // Contexts kept when idle; more are created on demand (0 = all, fixed pool)
+    int context_idle_ms = 60000;  // Free an extra context after this long unused
+    int pool_mb = 0;          // Memory ceiling for whisper states (0 = none)
+    int context_mb = 0;       // Memory per context for pool_mb (0 = measured on the first one)
+    int n_workers = 0;        // Concurrent decodes (0 = one per context)
     int n_threads = 4;        // Threads per inference
     int step_ms = 500;        // Run inference every N ms
+    int max_step_ms = 2000;   // Ceiling for the load-adaptive partial interval (<= step_ms disables)
     int length_ms = 5000;     // Audio context window
     int keep_ms = 200;        // Overlap between windows
+    int commit_ms = 5000;     // Decode audio that slid out of the window once this much builds up (0 = drop it)
     bool use_gpu = true;
     bool flash_attn = true;
     bool translate = false;
+    bool reuse_partial_final = true;  // Emit the last partial as final when no speech followed it
+    bool local_agreement = true;      // Commit the prefix two partials agree on; re-decode only the tail
+    bool warmup = true;               // Run one decode of silence on each new context before it is leased
+
+    // Partial encoder cost: size whisper's audio_ctx to the window instead of 30s
+    bool partial_audio_ctx = false;     // Finals always use the full context
+    int audio_ctx_margin_ms = 1000;     // Extra context beyond the window (accuracy guard)
 
     // VAD configuration (required)
     std::string vad_model_path = "";    // Path to VAD model (required)
     float vad_threshold = 0.5f;
     int vad_check_ms = 30;              // VAD cadence
+    int n_vad_contexts = 2;             // VAD threads, each with its own VAD context
+    bool vad_streaming = true;          // Analyze only new audio (false: re-check last vad_check_ms)
     int silence_trigger_ms = 1000;      // Silence before final
+    int admission_aging_ms = 5000;      // Head start per priority class when waiting for a context
+    int speculative_final_ms = 0;       // Silence before a speculative final on a spare context (0 = off)
     int min_speech_ms = 100;            // Ignore short utterances
+    int vad_preroll_ms = 400;           // Audio kept before speech onset while IDLE
 
     // Authentication
     std::string auth_token = "";        // Empty = no auth required
+    std::string priority_token = "";    // Required for ?priority=; empty = every session is NORMAL
 };
 
 // Forward declarations
 struct Session;
 class WhisperServer;
 
-// VAD speech state (managed by inference thread)
+// VAD speech state (managed by the VAD threads)
 enum class SpeechState { IDLE, WAITING_FOR_CONTEXT, SPEAKING, ENDING };
 
+// Kind of work dispatched to the inference worker pool.
+// COMMIT decodes audio that slid out of the partial window into committed text.
+// SPECULATIVE decodes a final ahead of time on a spare context, during a pause.
+enum class JobType { PARTIAL, COMMIT, FINAL, SPECULATIVE };
+
 // Context slot in the pool
+// Each slot owns a whisper_state (KV cache, mel, decoder buffers) on top of the
+// model weights shared by the whole pool. Whether it is free lives in the pool's
+// bitmap; the counters below are lease accounting for /metrics.
 struct ContextSlot {
-    whisper_context* ctx = nullptr;
-    bool in_use = false;  // Changed from atomic - we'll protect with mutex
+    whisper_state* state = nullptr;    // Only while live
     int slot_id = 0;
+    std::atomic<bool> live{false};     // Has a state (elastic pool: created on demand)
+    std::atomic<int64_t> released_at_ms{0};  // Last time it went back to the free bitmap
+
+    std::atomic<int64_t> leased_at_ms{0};      // Start of the current lease, 0 = free
+    std::atomic<uint64_t> lease_count{0};
+    std::atomic<uint64_t> lease_ms_total{0};   // Time spent leased, over finished leases
+    std::atomic<int64_t> lease_ms_max{0};
 };
 
 // Per-connection session
@@ -64,13 +100,52 @@ struct Session {
     ContextSlot* context_slot = nullptr;
     std::atomic<bool> active{true};
     std::atomic<bool> inference_running{false};
+    int priority = AdmissionQueue::NORMAL;  // Admission class when contexts run out
+    std::atomic<bool> cancel_job{false};  // Abort the job in flight (cleared when it ends)
 
-    // VAD state (managed by inference thread)
+    // Guards the speech state below plus context_slot, pcmf32_old, last_text and
+    // pending_text, which the VAD thread and inference workers both touch.
+    // Never held across whisper_full() or VAD inference.
+    std::mutex state_mutex;
+
+    // VAD state (managed by the VAD thread owning vad_shard)
+    int vad_shard = 0;
     SpeechState speech_state = SpeechState::IDLE;
     int64_t speech_start_ms = 0;        // When speech began
     int64_t last_speech_ms = 0;         // Last VAD-positive timestamp
     int64_t waiting_start_ms = 0;       // When we started waiting for context
+    std::atomic<uint64_t> vad_pos{0};   // Stream position VAD has analyzed up to
+
+    // Scheduler bookkeeping
+    std::atomic<int64_t> sched_due_ms{0};   // Earliest pending deadline, 0 = none (written under sched_mutex_)
+    int64_t job_dispatch_ms = 0;            // When the last job was dispatched
+    double partial_phase = 0.0;             // Fraction of the step this session's partials are offset by
+    bool partial_skipped = false;           // Last partial was dropped as stale (worker-owned)
     std::string pending_text;           // Last partial for potential final
+    bool partial_current = false;       // pending_text is the decode of the current pcmf32_old
+    uint64_t partial_end_pos = 0;       // Stream position just past the last partial's audio
+    uint64_t last_speech_pos = 0;       // Stream position up to the last VAD-positive audio
+
+    // Long utterances: audio that slid out of the partial window is decoded in
+    // the background (COMMIT jobs) so the final covers the whole utterance.
+    // Stream order: [committed_text audio][commit_audio][pcmf32_old]
+    std::string committed_text;         // Stable text for the utterance so far
+    std::vector<float> commit_audio;    // Slid-out audio not yet committed
+
+    // Local agreement: the prefix two consecutive partials agree on is committed
+    // and its audio dropped from pcmf32_old (worker-owned, one job per session)
+    std::vector<whisper_token> prev_tokens;       // Last partial's tokens for pcmf32_old
+    std::vector<whisper_token> committed_tokens;  // Tail of the committed text, prompts the next decode
+    std::string held_text;              // Agreed words whose audio waits in commit_audio (shown, not stable)
+    uint64_t window_end_pos = 0;        // Stream position just past pcmf32_old
+
+    // Speculative final: decoded on a spare context once a pause passes
+    // speculative_final_ms, and used by emitFinal if no speech followed
+    bool spec_started = false;          // Dispatched for the current pause
+    bool spec_ready = false;            // spec_text holds a final for audio up to spec_end_pos
+    std::atomic<uint32_t> spec_generation{0};  // Bumped to discard (and abort) the speculation in flight
+    std::string spec_text;
+    uint64_t spec_end_pos = 0;
 
     // WebSocket handle (event loop thread only)
     void* ws_handle = nullptr;
@@ -97,6 +172,68 @@ struct Session {
     }
 };
 
+// Unit of work for the inference worker pool.
+// The session's inference_running flag is set while the job is queued or running,
+// so at most one job per session (and therefore per leased context) is in flight.
+// SPECULATIVE jobs are the exception: they bring their own spare context and
+// run alongside the session's regular job.
+struct InferenceJob {
+    JobType type = JobType::PARTIAL;
+    std::shared_ptr<Session> session;
+    int64_t deadline_ms = 0;  // Finals: dispatch time. Partials: dispatch + step_ms.
+    ContextSlot* slot = nullptr;  // SPECULATIVE: spare context, released when the job ends
+    uint32_t generation = 0;      // SPECULATIVE: Session::spec_generation at dispatch
+};
+
+// Cancellation check handed to whisper_full() as its abort callback.
+// Polled from inside the decode, so it only reads atomics. Any job stops once its
+// session is closed; partials and commits also on Session::cancel_job, and
+// speculative finals once Session::spec_generation moves on.
+struct JobCancel {
+    const Session* session = nullptr;
+    JobType type = JobType::PARTIAL;
+    uint32_t generation = 0;
+
+    bool cancelled() const;
+};
+
+// Worker pick order: finals before everything else, then earliest deadline first
+struct InferenceJobLater {
+    bool operator()(const InferenceJob& a, const InferenceJob& b) const {
+        bool a_final = a.type == JobType::FINAL;
+        bool b_final = b.type == JobType::FINAL;
+        if (a_final != b_final) {
+            return b_final;
+        }
+        return a.deadline_ms > b.deadline_ms;
+    }
+};
+
+// Scheduler deadline: the session is looked at again once due_ms has passed.
+// An entry whose due_ms no longer matches Session::sched_due_ms is stale.
+struct ScheduledWake {
+    int64_t due_ms = 0;
+    std::weak_ptr<Session> session;
+
+    bool operator>(const ScheduledWake& other) const { return due_ms > other.due_ms; }
+};
+
+// One VAD pass over a shard of sessions: the sessions, and per session how much
+// new audio was analyzed and its speech probability. Buffers are reused from pass
+// to pass.
+struct VadPass {
+    std::vector<std::shared_ptr<Session>> sessions;
+    std::vector<float> samples;     // One session's new audio at a time (reused)
+    std::vector<size_t> counts;     // Samples analyzed per session (0 = no new audio)
+    std::vector<float> probs;       // Speech probability per session
+
+    void clear() {
+        sessions.clear();
+        counts.clear();
+        probs.clear();
+    }
+};
+
 // Main server class
 class WhisperServer {
 public:
@@ -118,7 +255,7 @@ public:
     // === Public methods for WebSocket handlers ===
 
     // Session management
-    std::shared_ptr<Session> createSession(const std::string& id);
+    std::shared_ptr<Session> createSession(const std::string& id, int priority = AdmissionQueue::NORMAL);
     void destroySession(const std::string& id);
 
     // Get pending messages for a session (called from uWS event loop thread)
@@ -134,39 +271,153 @@ public:
 
     // JSON message helpers
     std::string makeReadyMessage();
-    std::string makePartialMessage(const std::string& text);
+    std::string makePartialMessage(const std::string& text, const std::string& stable);
     std::string makeFinalMessage(const std::string& text);
     std::string makeErrorMessage(const std::string& error);
 
+    // Load and cadence snapshot for the /metrics endpoint
+    std::string makeMetricsJson();
+
 private:
     ServerConfig config_;
+
+    // A partial can stand in for the final only if it was decoded the way a final
+    // is: --partial-audio-ctx partials run with a truncated encoder context
+    bool reuse_partial_final_ = false;
+
+    whisper_context* model_ctx_ = nullptr;  // Model weights, shared by all slots
     std::vector<std::unique_ptr<ContextSlot>> context_pool_;  // Use unique_ptr
-    std::mutex context_pool_mutex_;  // Protect context pool access
+
+    // Elastic pool: context_pool_ holds n_contexts slots, but only live ones have a
+    // whisper_state. The pool thread creates states while sessions are queued and
+    // frees ones idle past context_idle_ms, keeping min_live_..max_live_ of them.
+    std::thread pool_thread_;
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    bool pool_grow_requested_ = false;      // Guarded by pool_mutex_
+    std::atomic<int> contexts_live_{0};
+    int min_live_ = 0;
+    int max_live_ = 0;                      // n_contexts, lowered to fit pool_mb
+    size_t context_bytes_ = 0;              // Memory per state (configured or measured)
+    std::atomic<uint64_t> contexts_created_{0};
+    std::atomic<uint64_t> contexts_freed_{0};
+
+    // Free slots as an atomic bitmap (bit i set = context_pool_[i] is live and free).
+    // Acquire claims the lowest set bit with a CAS and release sets it again,
+    // so neither takes a lock while nobody is waiting.
+    std::unique_ptr<std::atomic<uint64_t>[]> free_slots_;
+    size_t free_slot_words_ = 0;
+
+    // Sessions waiting for a context, and slots handed to a waiter that hasn't
+    // picked them up yet (its next VAD tick). Guarded by admission_mutex_;
+    // admission_pending_ mirrors their total so the fast paths can skip the lock.
+    std::mutex admission_mutex_;
+    std::atomic<int> admission_pending_{0};
+    AdmissionQueue admission_queue_;
+    std::unordered_map<std::string, ContextSlot*> admission_grants_;
+    uint64_t admissions_ = 0;               // Contexts handed over through the queue
+    int64_t admission_wait_ms_total_ = 0;
+    int64_t admission_wait_ms_worst_ = 0;
     std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
     std::mutex sessions_mutex_;
+    std::condition_variable sessions_cv_;  // Signaled when a session is created (wakes idle VAD threads)
 
     std::atomic<bool> running_{false};
     std::thread inference_thread_;
 
-    // VAD context (shared across sessions, mutex-protected)
-    whisper_vad_context* vad_ctx_ = nullptr;
-    std::mutex vad_mutex_;
+    // Event-driven scheduler: min-heap of per-session deadlines
+    std::priority_queue<ScheduledWake, std::vector<ScheduledWake>, std::greater<ScheduledWake>> sched_heap_;
+    std::mutex sched_mutex_;
+    std::condition_variable sched_cv_;
+    std::atomic<uint32_t> next_phase_index_{0};
+
+    // Load tracking: drives the adaptive partial cadence and /metrics
+    std::atomic<int> contexts_in_use_{0};
+    std::atomic<int> effective_step_ms_{0};     // Current partial interval (step_ms..max_step_ms)
+    std::atomic<uint64_t> partials_run_{0};
+    std::atomic<uint64_t> partials_skipped_{0};
+    std::atomic<uint64_t> finals_run_{0};
+    std::atomic<uint64_t> commits_run_{0};
+    std::atomic<uint64_t> finals_reused_{0};    // Finals emitted from the last partial, no decode
+    std::atomic<uint64_t> speculative_run_{0};
+    std::atomic<uint64_t> speculative_used_{0};  // Finals emitted from a speculative decode
+    std::atomic<uint64_t> jobs_cancelled_{0};    // Decodes aborted mid-run
+
+    // Startup timing for /metrics (set once in init())
+    int64_t model_load_ms_ = 0;
+    int64_t contexts_ready_ms_ = 0;   // Creating and warming the initial contexts
+    int64_t startup_ms_ = 0;          // init() start to ready
+    std::mutex load_mutex_;
+    double partial_ms_avg_ = 0.0;               // EWMA of partial inference time
+    double final_ms_avg_ = 0.0;                 // EWMA of final inference time
+
+    // VAD threads (one per VAD context); sessions are sharded across them
+    std::vector<std::thread> vad_threads_;
+    std::atomic<int> next_vad_shard_{0};
+
+    // Inference worker pool (one worker per context slot unless --workers caps it)
+    std::vector<std::thread> worker_threads_;
+    std::priority_queue<InferenceJob, std::vector<InferenceJob>, InferenceJobLater> job_queue_;
+    std::mutex job_mutex_;
+    std::condition_variable job_cv_;
+
+    // VAD context pool: a context is leased for one detection call, so
+    // checks for different sessions can run concurrently
+    std::vector<whisper_vad_context*> vad_pool_;
+    std::vector<whisper_vad_context*> vad_free_;
+    std::mutex vad_pool_mutex_;
+    std::condition_variable vad_pool_cv_;
 
     // Event loop for deferred message flushing
     void* loop_ = nullptr;
 
     // Context pool management
-    ContextSlot* acquireContext();
+    // acquireContext() queues the session when nothing is free (unless wait is
+    // false) and returns the slot handed to it once one is released
+    ContextSlot* acquireContext(const Session& session, bool wait = true);
     void releaseContext(ContextSlot* slot);
-
-    // Inference loop
+    void leaveAdmissionQueue(const Session& session);
+    void offerSlot(ContextSlot* slot);    // To the next waiter, else back to the bitmap
+    ContextSlot* claimFreeSlot();
+    bool claimSlot(ContextSlot* slot);    // Take this particular slot if it is free
+    bool createSlotState(ContextSlot* slot);
+    void warmUpState(whisper_state* state);
+    void requestPoolGrowth();
+    void poolLoop();
+    void growPool();
+    void shrinkPool(int64_t now_ms);
+    void beginLease(ContextSlot* slot);
+    int64_t endLease(ContextSlot* slot);  // Returns how long the slot was held
+    std::pair<std::string, int64_t> grantLocked(ContextSlot* slot);  // Next waiter's id and wait
+
+    // Inference loop (schedules jobs) and worker pool (runs them)
     void inferenceLoop();
-    void runInference(std::shared_ptr<Session> session);
+    void scheduleSession(const std::shared_ptr<Session>& session, int64_t due_ms);
+    int64_t partialSlot(const Session& session, int64_t due_ms, int64_t now_ms) const;
+    void serviceSession(const std::shared_ptr<Session>& session);
+    void recordJobTime(JobType type, double elapsed_ms, bool queued_behind);
+    void dispatchJob(JobType type, std::shared_ptr<Session> session);
+    void workerLoop();
+    // Return true if a whisper decode ran to completion (only those are timed)
+    bool runInference(std::shared_ptr<Session> session);
+    bool commitSlidAudio(std::shared_ptr<Session> session);
+    void dispatchSpeculativeFinal(const std::shared_ptr<Session>& session);
+    void runSpeculativeFinal(const InferenceJob& job);
+    void discardSpeculativeFinal(Session& session);
+    // Settings every decode shares (greedy, quiet, language, threads, abort wiring
+    // when cancel is given); callers add what their job type needs
+    whisper_full_params makeDecodeParams(JobCancel* cancel) const;
+    std::string decodeFinalText(whisper_state* state, const std::vector<float>& pcmf32,
+                                const std::vector<whisper_token>& prompt, JobCancel& cancel);
 
     // VAD methods
-    float detectSpeechProb(const float* samples, int n_samples);
-    void updateVADState(std::shared_ptr<Session> session, int64_t now_ms);
-    void emitFinal(std::shared_ptr<Session> session);
+    void vadLoop(int shard);
+    whisper_vad_context* acquireVadContext();
+    void releaseVadContext(whisper_vad_context* vad_ctx);
+    size_t gatherVadInput(Session& session, std::vector<float>& out);
+    void runVadPass(VadPass& pass);
+    void updateVADState(std::shared_ptr<Session> session, bool have_audio, float speech_prob, int64_t now_ms);
+    bool emitFinal(std::shared_ptr<Session> session);
 
     // Message flush methods
     void notifySessionHasMessages(const std::string& session_id);
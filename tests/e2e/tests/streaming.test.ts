@@ -96,6 +96,23 @@ describe('Streaming', () => {
     // This test verifies the server doesn't crash under load.
   });
 
+  it('stable prefix keeps growing through long speech', async () => {
+    const chunks = loadWavAsChunks(JFK_WAV, 100);
+
+    // ~33s of speech, longer than the window plus a --commit chunk, streamed
+    // faster than real time so audio slides out of the window
+    await client.sendChunks(chunks, 40);
+    await client.sendChunks(chunks, 40);
+    const before = client.getStablePrefixes().length;
+    await client.sendChunks(chunks, 40);
+    await new Promise((r) => setTimeout(r, 1000));
+
+    // Local agreement must still be committing words in the last pass, not
+    // only the COMMIT job every --commit ms of slid-out audio
+    const lastPass = client.getStablePrefixes().slice(before);
+    expect(new Set(lastPass).size).toBeGreaterThanOrEqual(3);
+  }, 60000);
+
   it('streams at real-time speed', async () => {
     const chunks = loadWavAsChunks(JFK_WAV, 100);  // 100ms chunks
 
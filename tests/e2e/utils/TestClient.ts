@@ -17,6 +17,7 @@ interface ReadyMessage {
 interface PartialMessage {
   type: 'partial';
   text: string;
+  stable?: string;  // Prefix of text that later partials keep unchanged
 }
 
 interface FinalMessage {
@@ -219,6 +220,15 @@ export class TestClient {
       .map((m) => (m as PartialMessage).text);
   }
 
+  /**
+   * Get the stable prefix of each partial message ('' if absent)
+   */
+  getStablePrefixes(): string[] {
+    return this.messages
+      .filter((m) => m.type === 'partial')
+      .map((m) => (m as PartialMessage).stable ?? '');
+  }
+
   /**
    * Get all final messages
    */
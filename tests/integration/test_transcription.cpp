@@ -282,3 +282,53 @@ TEST_CASE("Integration: Context initialization and cleanup", "[integration][cont
         whisper_free(ctx);
     }
 }
+
+TEST_CASE("Integration: Pooled states share one model", "[integration][context]") {
+    if (!testDependenciesAvailable()) {
+        WARN("Skipping test: model or fixture not found");
+        SUCCEED("Test skipped - dependencies not found");
+        return;
+    }
+
+    std::vector<float> samples = loadWav(JFK_WAV_PATH);
+
+    // Load weights once, then create two independent inference states
+    whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = true;
+
+    whisper_context* ctx = whisper_init_from_file_with_params_no_state(MODEL_PATH, cparams);
+    REQUIRE(ctx != nullptr);
+
+    whisper_state* state_a = whisper_init_state(ctx);
+    whisper_state* state_b = whisper_init_state(ctx);
+    REQUIRE(state_a != nullptr);
+    REQUIRE(state_b != nullptr);
+
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.print_progress = false;
+    wparams.print_special = false;
+    wparams.print_realtime = false;
+    wparams.print_timestamps = false;
+    wparams.n_threads = 4;
+    wparams.language = "en";
+
+    // Each state must produce the same transcript independently
+    for (whisper_state* state : {state_a, state_b}) {
+        REQUIRE(whisper_full_with_state(ctx, state, wparams, samples.data(), samples.size()) == 0);
+
+        std::string text;
+        for (int i = 0; i < whisper_full_n_segments_from_state(state); i++) {
+            text += whisper_full_get_segment_text_from_state(state, i);
+        }
+
+        std::string lower_text;
+        for (char c : text) {
+            lower_text += std::tolower(c);
+        }
+        REQUIRE_THAT(lower_text, ContainsSubstring("country"));
+    }
+
+    whisper_free_state(state_a);
+    whisper_free_state(state_b);
+    whisper_free(ctx);
+}
@@ -0,0 +1,92 @@
+/**
+ * Unit tests for the context admission queue
+ *
+ * Released contexts must go to waiters in arrival order within a priority
+ * class, higher classes first, and aging must let a long-waiting low-priority
+ * session overtake newer high-priority ones.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "admission_queue.hpp"
+
+TEST_CASE("AdmissionQueue: FIFO within one priority class", "[admission]") {
+    AdmissionQueue queue(5000);
+    queue.push("a", AdmissionQueue::NORMAL, 0);
+    queue.push("b", AdmissionQueue::NORMAL, 10);
+    queue.push("c", AdmissionQueue::NORMAL, 20);
+
+    REQUIRE(queue.size() == 3);
+    REQUIRE(queue.pop(100).id == "a");
+    REQUIRE(queue.pop(100).id == "b");
+    REQUIRE(queue.pop(100).id == "c");
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("AdmissionQueue: ties go to the earliest arrival", "[admission]") {
+    AdmissionQueue queue(0);
+    queue.push("a", AdmissionQueue::HIGH, 50);
+    queue.push("b", AdmissionQueue::LOW, 50);
+
+    REQUIRE(queue.pop(50).id == "a");
+}
+
+TEST_CASE("AdmissionQueue: higher class is served first", "[admission]") {
+    AdmissionQueue queue(5000);
+    queue.push("low", AdmissionQueue::LOW, 0);
+    queue.push("normal", AdmissionQueue::NORMAL, 100);
+    queue.push("high", AdmissionQueue::HIGH, 200);
+
+    REQUIRE(queue.pop(300).id == "high");
+    REQUIRE(queue.pop(300).id == "normal");
+    REQUIRE(queue.pop(300).id == "low");
+}
+
+TEST_CASE("AdmissionQueue: aging bounds how long a lower class waits", "[admission]") {
+    AdmissionQueue queue(1000);
+    queue.push("low", AdmissionQueue::LOW, 0);
+    queue.push("high", AdmissionQueue::HIGH, 1500);
+
+    // low has waited 1600ms, high 100ms + 2 classes * 1000ms
+    REQUIRE(queue.pop(1600).id == "high");
+
+    queue.push("high2", AdmissionQueue::HIGH, 1600);
+    // low: 2500ms, high2: 900ms + 2000ms
+    REQUIRE(queue.pop(2500).id == "high2");
+
+    queue.push("high3", AdmissionQueue::HIGH, 2500);
+    // low: 3000ms, high3: 500ms + 2000ms
+    REQUIRE(queue.pop(3000).id == "low");
+}
+
+TEST_CASE("AdmissionQueue: push is idempotent and keeps the original place", "[admission]") {
+    AdmissionQueue queue(5000);
+    REQUIRE(queue.push("a", AdmissionQueue::NORMAL, 0));
+    REQUIRE(queue.push("b", AdmissionQueue::NORMAL, 10));
+    REQUIRE_FALSE(queue.push("a", AdmissionQueue::NORMAL, 20));
+
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.oldestWaitMs(100) == 100);
+    REQUIRE(queue.pop(100).id == "a");
+}
+
+TEST_CASE("AdmissionQueue: remove drops a waiter", "[admission]") {
+    AdmissionQueue queue(5000);
+    queue.push("a", AdmissionQueue::NORMAL, 0);
+    queue.push("b", AdmissionQueue::NORMAL, 10);
+
+    REQUIRE(queue.remove("a"));
+    REQUIRE_FALSE(queue.remove("a"));
+    REQUIRE_FALSE(queue.contains("a"));
+    REQUIRE(queue.contains("b"));
+    REQUIRE(queue.oldestWaitMs(50) == 40);
+    REQUIRE(queue.pop(50).id == "b");
+    REQUIRE(queue.oldestWaitMs(50) == 0);
+}
+
+TEST_CASE("AdmissionQueue: priority names", "[admission]") {
+    REQUIRE(AdmissionQueue::parsePriority("low") == AdmissionQueue::LOW);
+    REQUIRE(AdmissionQueue::parsePriority("high") == AdmissionQueue::HIGH);
+    REQUIRE(AdmissionQueue::parsePriority("normal") == AdmissionQueue::NORMAL);
+    REQUIRE(AdmissionQueue::parsePriority("") == AdmissionQueue::NORMAL);
+    REQUIRE(AdmissionQueue::parsePriority("urgent") == AdmissionQueue::NORMAL);
+}
@@ -1,7 +1,7 @@
 /**
  * Unit tests for AudioBuffer class
  *
- * Tests the thread-safe ring buffer that accumulates incoming PCM audio
+ * Tests the lock-free SPSC ring buffer that accumulates incoming PCM audio
  * and converts int16 to float32 for whisper inference.
  */
 
@@ -305,10 +305,276 @@ TEST_CASE("AudioBuffer: pushFloat adds float samples directly", "[audio][buffer]
     REQUIRE_THAT(result[4], WithinAbs(-1.0f, 0.0001f));
 }
 
+// ============================================================================
+// Ring buffer (peek / consume / wraparound) Tests
+// ============================================================================
+
+TEST_CASE("AudioBuffer: peek returns a single span before wraparound", "[audio][ring]") {
+    AudioBuffer buffer(1.0f, 16000);
+
+    int16_t samples[] = {1000, 2000, 3000};
+    buffer.push(samples, 3);
+
+    AudioBuffer::Span first, second;
+    REQUIRE(buffer.peek(first, second) == 3);
+    REQUIRE(first.size == 3);
+    REQUIRE(second.size == 0);
+    REQUIRE_THAT(first.data[2], WithinAbs(3000.0f / 32768.0f, 0.0001f));
+}
+
+TEST_CASE("AudioBuffer: peek splits wrapped data into two spans in order", "[audio][ring]") {
+    // 0.1s at 16kHz = 1600 retained samples; the ring wraps after a few pushes
+    AudioBuffer buffer(0.1f, 16000);
+
+    std::vector<float> chunk(1000);
+    float next = 0.0f;
+    for (int round = 0; round < 7; ++round) {
+        for (auto& s : chunk) s = next++;
+        buffer.pushFloat(chunk.data(), chunk.size());
+    }
+
+    AudioBuffer::Span first, second;
+    size_t total = buffer.peek(first, second);
+    REQUIRE(total == 1600);
+    REQUIRE(first.size + second.size == total);
+    REQUIRE(second.size > 0);
+
+    // Spans concatenate to the newest 1600 samples, oldest first
+    std::vector<float> joined(first.data, first.data + first.size);
+    joined.insert(joined.end(), second.data, second.data + second.size);
+    for (size_t i = 0; i < joined.size(); ++i) {
+        REQUIRE(joined[i] == static_cast<float>(7000 - 1600 + i));
+    }
+    REQUIRE(joined == buffer.getAll());
+}
+
+TEST_CASE("AudioBuffer: consume removes oldest samples", "[audio][ring]") {
+    AudioBuffer buffer(1.0f, 16000);
+
+    int16_t samples[] = {1000, 2000, 3000, 4000, 5000};
+    buffer.push(samples, 5);
+
+    buffer.consume(2);
+    REQUIRE(buffer.size() == 3);
+
+    std::vector<float> remaining = buffer.getAll();
+    REQUIRE_THAT(remaining[0], WithinAbs(3000.0f / 32768.0f, 0.0001f));
+
+    // Consuming more than available just empties the buffer
+    buffer.consume(100);
+    REQUIRE(buffer.size() == 0);
+
+    // New samples after a consume are still readable
+    buffer.push(samples, 1);
+    REQUIRE(buffer.size() == 1);
+}
+
+TEST_CASE("AudioBuffer: getLastMs after wraparound", "[audio][ring]") {
+    AudioBuffer buffer(0.1f, 16000);
+
+    std::vector<float> chunk(710);
+    float next = 0.0f;
+    for (int round = 0; round < 8; ++round) {
+        for (auto& s : chunk) s = next++;
+        buffer.pushFloat(chunk.data(), chunk.size());
+    }
+
+    // Last 10ms = 160 samples, ending at the newest sample
+    std::vector<float> result = buffer.getLastMs(10);
+    REQUIRE(result.size() == 160);
+    REQUIRE(result.front() == next - 160);
+    REQUIRE(result.back() == next - 1);
+}
+
+TEST_CASE("AudioBuffer: keepLastMs keeps only the newest audio", "[audio][ring]") {
+    AudioBuffer buffer(1.0f, 16000);
+
+    std::vector<float> samples(1600);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = static_cast<float>(i);
+    buffer.pushFloat(samples.data(), samples.size());
+
+    // 10ms = 160 samples
+    buffer.keepLastMs(10);
+    std::vector<float> result = buffer.getAll();
+    REQUIRE(result.size() == 160);
+    REQUIRE(result.front() == 1440.0f);
+    REQUIRE(result.back() == 1599.0f);
+
+    // Keeping more than is buffered is a no-op
+    buffer.keepLastMs(1000);
+    REQUIRE(buffer.size() == 160);
+}
+
+TEST_CASE("AudioBuffer: idle pre-roll trimming keeps data intact across wraps", "[audio][ring]") {
+    // Simulates a long idle session: push 100ms frames, keep a 20ms pre-roll.
+    // Consumed pages are returned to the OS; retained samples must be unaffected.
+    for (auto format : {AudioBuffer::SampleFormat::FLOAT32, AudioBuffer::SampleFormat::INT16}) {
+        AudioBuffer buffer(1.0f, 16000, format);
+
+        std::vector<int16_t> frame(1600);
+        int16_t next = 0;
+        for (int i = 0; i < 200; ++i) {  // 20s of audio through a 1s buffer
+            for (auto& s : frame) {
+                s = next;
+                next = static_cast<int16_t>((next + 1) & 0x3fff);
+            }
+            buffer.push(frame.data(), frame.size());
+            buffer.keepLastMs(20);
+
+            std::vector<float> kept = buffer.getAll();
+            REQUIRE(kept.size() == 320);
+            for (size_t k = 0; k < kept.size(); ++k) {
+                REQUIRE(kept[k] * 32768.0f == static_cast<float>(frame[frame.size() - 320 + k]));
+            }
+        }
+
+        // Speech onset: the buffer fills back up normally after trimming
+        for (int i = 0; i < 10; ++i) buffer.push(frame.data(), frame.size());
+        REQUIRE(buffer.size() == 16000);
+        REQUIRE(buffer.getAll().back() * 32768.0f == static_cast<float>(frame.back()));
+    }
+}
+
+TEST_CASE("AudioBuffer: getFrom reads by absolute stream position", "[audio][ring]") {
+    AudioBuffer buffer(0.1f, 16000);  // 1600 retained samples
+
+    std::vector<float> samples(1000);
+    for (size_t i = 0; i < samples.size(); ++i) samples[i] = static_cast<float>(i);
+    buffer.pushFloat(samples.data(), samples.size());
+    REQUIRE(buffer.writePosition() == 1000);
+    REQUIRE(buffer.readPosition() == 0);
+
+    // Read a window from the middle; nothing is consumed
+    uint64_t pos = 200;
+    float out[512];
+    REQUIRE(buffer.getFrom(pos, out, 512) == 512);
+    REQUIRE(pos == 200);
+    REQUIRE(out[0] == 200.0f);
+    REQUIRE(buffer.size() == 1000);
+
+    // Positions stay valid after the consumer moves on: stale ones are clamped
+    buffer.consume(600);
+    REQUIRE(buffer.readPosition() == 600);
+    pos = 100;
+    REQUIRE(buffer.getFrom(pos, out, 512) == 400);
+    REQUIRE(pos == 600);
+    REQUIRE(out[0] == 600.0f);
+
+    // At the write position there is nothing new
+    pos = buffer.writePosition();
+    REQUIRE(buffer.getFrom(pos, out, 512) == 0);
+}
+
+// ============================================================================
+// Int16 storage mode Tests
+// ============================================================================
+
+TEST_CASE("AudioBuffer: int16 mode converts on read", "[audio][int16]") {
+    AudioBuffer buffer(1.0f, 16000, AudioBuffer::SampleFormat::INT16);
+    REQUIRE(buffer.format() == AudioBuffer::SampleFormat::INT16);
+
+    int16_t samples[] = {32767, -32768, 0, 16384};
+    buffer.push(samples, 4);
+
+    // Reads are bit-identical to what FLOAT32 mode stores
+    AudioBuffer reference(1.0f, 16000);
+    reference.push(samples, 4);
+    REQUIRE(buffer.getAll() == reference.getAll());
+
+    std::vector<float> last = buffer.getLastMs(1);  // 16 samples requested, 4 available
+    REQUIRE(last.size() == 4);
+    REQUIRE_THAT(last[1], WithinAbs(-1.0f, 0.0001f));
+}
+
+TEST_CASE("AudioBuffer: int16 mode pushFloat quantizes and clamps", "[audio][int16]") {
+    AudioBuffer buffer(1.0f, 16000, AudioBuffer::SampleFormat::INT16);
+
+    float samples[] = {0.5f, -0.5f, 0.0f, 1.0f, -1.0f, 2.0f};
+    buffer.pushFloat(samples, 6);
+
+    std::vector<float> result = buffer.getAll();
+    REQUIRE(result.size() == 6);
+    REQUIRE(result[0] == 0.5f);
+    REQUIRE(result[1] == -0.5f);
+    REQUIRE(result[2] == 0.0f);
+    REQUIRE(result[3] == 32767.0f / 32768.0f);  // Clamped to int16 max
+    REQUIRE(result[4] == -1.0f);
+    REQUIRE(result[5] == 32767.0f / 32768.0f);
+}
+
+TEST_CASE("AudioBuffer: int16 mode peek and get after wraparound", "[audio][int16]") {
+    AudioBuffer buffer(0.1f, 16000, AudioBuffer::SampleFormat::INT16);
+
+    std::vector<int16_t> chunk(1000);
+    int16_t next = 0;
+    for (int round = 0; round < 7; ++round) {
+        for (auto& s : chunk) s = next++;
+        buffer.push(chunk.data(), chunk.size());
+    }
+
+    // Float spans are not available for int16 storage
+    AudioBuffer::Span f1, f2;
+    REQUIRE(buffer.peek(f1, f2) == 0);
+
+    AudioBuffer::Int16Span first, second;
+    REQUIRE(buffer.peekInt16(first, second) == 1600);
+    REQUIRE(second.size > 0);
+    REQUIRE(first.data[0] == 7000 - 1600);
+    REQUIRE(second.data[second.size - 1] == 6999);
+
+    std::vector<float> out(1600);
+    REQUIRE(buffer.get(out.data(), out.size(), true) == 1600);
+    REQUIRE(out[0] == (7000 - 1600) / 32768.0f);
+    REQUIRE(out[1599] == 6999 / 32768.0f);
+    REQUIRE(buffer.size() == 0);
+}
+
 // ============================================================================
 // Thread Safety Tests
 // ============================================================================
 
+TEST_CASE("AudioBuffer: single producer/consumer preserves sample order", "[audio][thread]") {
+    AudioBuffer buffer(0.1f, 16000);
+    std::atomic<bool> stop{false};
+    std::atomic<bool> ordered{true};
+
+    // Producer pushes a running counter (wraps at 2^15)
+    std::thread writer([&]() {
+        int16_t samples[160];
+        int16_t counter = 0;
+        while (!stop) {
+            for (auto& s : samples) {
+                s = counter;
+                counter = static_cast<int16_t>((counter + 1) & 0x7fff);
+            }
+            buffer.push(samples, 160);
+        }
+    });
+
+    // Consumer drains; samples may be dropped on overflow but never reordered
+    std::thread reader([&]() {
+        std::vector<float> out(4096);
+        while (!stop) {
+            size_t n = buffer.get(out.data(), out.size(), true);
+            for (size_t i = 1; i < n; ++i) {
+                float step = (out[i] - out[i - 1]) * 32768.0f;
+                if (step != 1.0f && step != -32767.0f) {
+                    ordered = false;
+                }
+            }
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stop = true;
+
+    writer.join();
+    reader.join();
+
+    REQUIRE(ordered);
+}
+
+
 TEST_CASE("AudioBuffer: concurrent push and getAll", "[audio][thread]") {
     AudioBuffer buffer(1.0f, 16000);
     std::atomic<bool> stop{false};
@@ -408,3 +674,52 @@ TEST_CASE("AudioBuffer: concurrent push and getLastMs", "[audio][thread]") {
 
     REQUIRE(operations > 0);
 }
+
+TEST_CASE("AudioBuffer: readers never see pages released after a concurrent clear", "[audio][thread]") {
+    // The producer returns consumed pages to the OS; a reader that started before
+    // the clear must drop them rather than return zeros
+    AudioBuffer buffer(30.0f, 16000, AudioBuffer::SampleFormat::INT16);
+    std::atomic<bool> stop{false};
+    std::atomic<int> zeros{0};
+    std::atomic<int> reads{0};
+
+    std::thread writer([&]() {
+        std::vector<int16_t> samples(64000, 1000);  // Never zero
+        while (!stop) {
+            buffer.push(samples.data(), samples.size());
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::thread clearer([&]() {
+        while (!stop) {
+            buffer.clear();
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    });
+
+    std::thread reader([&]() {
+        std::vector<float> out(30 * 16000);
+        while (!stop) {
+            uint64_t pos = 0;
+            size_t n = buffer.getFrom(pos, out.data(), out.size());
+            for (size_t i = 0; i < n; ++i) {
+                if (out[i] == 0.0f) {
+                    zeros++;
+                    break;
+                }
+            }
+            reads++;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop = true;
+
+    writer.join();
+    clearer.join();
+    reader.join();
+
+    REQUIRE(reads > 0);
+    REQUIRE(zeros == 0);
+}
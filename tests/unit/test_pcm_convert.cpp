@@ -0,0 +1,90 @@
+/**
+ * Unit tests for int16 -> float32 PCM conversion kernels
+ *
+ * Every SIMD kernel the running CPU supports must match the scalar
+ * reference bit-for-bit, for every int16 value and for any length or
+ * alignment (so the vector body and the scalar tail are both covered).
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "pcm_convert.hpp"
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+// Bitwise comparison (also distinguishes -0.0f from 0.0f)
+static bool bitEqual(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+TEST_CASE("PcmConvert: scalar reference matches int16 / 32768", "[pcm][conversion]") {
+    int16_t samples[] = {0, 1, -1, 16384, -16384, 32767, -32768};
+    float out[7];
+    pcmInt16ToFloatScalar(samples, out, 7);
+
+    for (int i = 0; i < 7; ++i) {
+        REQUIRE(out[i] == static_cast<float>(samples[i]) / 32768.0f);
+    }
+    REQUIRE(out[6] == -1.0f);
+}
+
+TEST_CASE("PcmConvert: active kernel is one of the supported kernels", "[pcm][dispatch]") {
+    const PcmConvertKernel* kernels[8];
+    size_t n = pcmSupportedKernels(kernels, 8);
+
+    REQUIRE(n >= 1);
+    REQUIRE(std::strcmp(kernels[0]->name, "scalar") == 0);
+
+    bool found = false;
+    for (size_t k = 0; k < n; ++k) {
+        if (kernels[k] == &pcmActiveKernel()) found = true;
+    }
+    REQUIRE(found);
+}
+
+TEST_CASE("PcmConvert: every kernel is bit-exact over all int16 values", "[pcm][conversion]") {
+    std::vector<int16_t> all(65536);
+    for (int v = -32768; v <= 32767; ++v) {
+        all[v + 32768] = static_cast<int16_t>(v);
+    }
+
+    std::vector<float> expected(all.size());
+    pcmInt16ToFloatScalar(all.data(), expected.data(), all.size());
+
+    const PcmConvertKernel* kernels[8];
+    size_t n = pcmSupportedKernels(kernels, 8);
+    for (size_t k = 0; k < n; ++k) {
+        std::vector<float> actual(all.size());
+        kernels[k]->convert(all.data(), actual.data(), all.size());
+        INFO("kernel " << kernels[k]->name);
+        REQUIRE(bitEqual(actual, expected));
+    }
+
+    std::vector<float> dispatched(all.size());
+    pcmInt16ToFloat(all.data(), dispatched.data(), all.size());
+    REQUIRE(bitEqual(dispatched, expected));
+}
+
+TEST_CASE("PcmConvert: odd lengths and unaligned pointers", "[pcm][conversion]") {
+    // Offset by one element so loads/stores are not vector-aligned
+    std::vector<int16_t> src(128 + 1);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<int16_t>(i * 517 - 30000);
+    }
+
+    const PcmConvertKernel* kernels[8];
+    size_t n = pcmSupportedKernels(kernels, 8);
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t len = 0; len <= 128; ++len) {
+            std::vector<float> expected(len + 1, 42.0f);
+            std::vector<float> actual(len + 1, 42.0f);
+            pcmInt16ToFloatScalar(src.data() + 1, expected.data(), len);
+            kernels[k]->convert(src.data() + 1, actual.data(), len);
+
+            INFO("kernel " << kernels[k]->name << " len " << len);
+            REQUIRE(bitEqual(actual, expected));  // Includes the untouched sentinel
+        }
+    }
+}